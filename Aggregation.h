@@ -0,0 +1,398 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Student.h"
+#include "Metrics.h"
+
+// Grouping columns for grade aggregation (e.g. "branch,year,course")
+enum class GroupKey {
+    Branch,
+    Year,
+    Course,
+    Semester
+};
+
+inline const char* groupKeyName(GroupKey key) {
+    switch (key) {
+        case GroupKey::Branch: return "branch";
+        case GroupKey::Year: return "year";
+        case GroupKey::Course: return "course";
+        case GroupKey::Semester: return "semester";
+    }
+    return "unknown";
+}
+
+// Parse a comma-separated key list such as "branch,year,course"
+// Throws invalid_argument on an unknown or repeated key
+inline std::vector<GroupKey> parseGroupKeys(const std::string& spec) {
+    std::vector<GroupKey> keys;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string name = spec.substr(start, end - start);
+
+        GroupKey key;
+        if (name == "branch") key = GroupKey::Branch;
+        else if (name == "year") key = GroupKey::Year;
+        else if (name == "course") key = GroupKey::Course;
+        else if (name == "semester") key = GroupKey::Semester;
+        else throw std::invalid_argument("Unknown group key '" + name + "' (use branch/year/course/semester)");
+        if (std::find(keys.begin(), keys.end(), key) != keys.end()) {
+            throw std::invalid_argument("Group key '" + name + "' given twice");
+        }
+        keys.push_back(key);
+
+        start = end + 1;
+    }
+    return keys;
+}
+
+// count/sum/avg/min/max and a histogram of getGradePoints() over enrollments
+struct GradeAggregate {
+    static constexpr int MAX_POINTS = 10;
+    using Histogram = std::array<unsigned long long, MAX_POINTS + 1>;
+
+    unsigned long long count = 0;
+    long long sum = 0;
+    int min = INT_MAX;
+    int max = INT_MIN;
+    Histogram histogram{};  // Enrollments per grade point value
+
+    void add(int points) {
+        count++;
+        sum += points;
+        min = std::min(min, points);
+        max = std::max(max, points);
+        histogram[std::clamp(points, 0, MAX_POINTS)]++;
+    }
+
+    // Grade points are 0..MAX_POINTS, so the histogram determines the rest
+    static GradeAggregate fromHistogram(const Histogram& counts) {
+        GradeAggregate result;
+        result.histogram = counts;
+        for (int points = 0; points <= MAX_POINTS; points++) {
+            if (counts[points] == 0) continue;
+            result.count += counts[points];
+            result.sum += static_cast<long long>(counts[points]) * points;
+            result.min = std::min(result.min, points);
+            result.max = std::max(result.max, points);
+        }
+        return result;
+    }
+
+    void merge(const GradeAggregate& other) {
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        for (size_t i = 0; i < histogram.size(); i++) histogram[i] += other.histogram[i];
+    }
+
+    double average() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+};
+
+// Key columns of one group, packed: interned string pointers (branch, IIIT
+// course code) or integers. Four words cover every GroupKey at once.
+using GroupTuple = std::array<uint64_t, 4>;
+
+struct GroupTupleHash {
+    // Independent multiplies per word, then one mixing round
+    size_t operator()(const GroupTuple& tuple) const {
+        uint64_t h = tuple[0] * 0x9E3779B97F4A7C15ULL ^ tuple[1] * 0xC2B2AE3D27D4EB4FULL ^
+                     tuple[2] * 0x165667B19E3779F9ULL ^ tuple[3] * 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 29;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+// Open-addressing hash table from GroupTuple to a grade histogram. Report
+// groups number in the hundreds or thousands, so the table stays in cache
+// and a lookup is a hash plus a short linear probe.
+class GroupTable {
+private:
+    std::vector<GroupTuple> keys;                        // Insertion order
+    std::vector<GradeAggregate::Histogram> histograms;   // Parallel to keys
+    std::vector<int32_t> slots;                          // Index into keys, -1 = empty
+    size_t mask = 0;
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, -1);
+        mask = capacity - 1;
+        GroupTupleHash hash;
+        for (size_t i = 0; i < keys.size(); i++) {
+            size_t slot = hash(keys[i]) & mask;
+            while (slots[slot] >= 0) slot = (slot + 1) & mask;
+            slots[slot] = static_cast<int32_t>(i);
+        }
+    }
+
+public:
+    GroupTable() { rehash(64); }
+
+    // Histogram of tuple (hashed to hashValue), inserted empty if new
+    GradeAggregate::Histogram& find(const GroupTuple& tuple, size_t hashValue) {
+        size_t slot = hashValue & mask;
+        while (slots[slot] >= 0) {
+            int32_t index = slots[slot];
+            if (keys[index] == tuple) return histograms[index];
+            slot = (slot + 1) & mask;
+        }
+        if (2 * (keys.size() + 1) > slots.size()) {  // Keep the load factor under 1/2
+            keys.push_back(tuple);
+            histograms.emplace_back();
+            rehash(2 * slots.size());
+            return histograms.back();
+        }
+        slots[slot] = static_cast<int32_t>(keys.size());
+        keys.push_back(tuple);
+        histograms.emplace_back();
+        return histograms.back();
+    }
+
+    size_t size() const { return keys.size(); }
+
+    void swap(GroupTable& other) noexcept {
+        keys.swap(other.keys);
+        histograms.swap(other.histograms);
+        slots.swap(other.slots);
+        std::swap(mask, other.mask);
+    }
+
+    const GroupTuple& keyAt(size_t i) const { return keys[i]; }
+    const GradeAggregate::Histogram& histogramAt(size_t i) const { return histograms[i]; }
+};
+
+struct AggregateGroup {
+    GroupTuple tuple;                // Packed key (see GroupTuple)
+    std::vector<std::string> key;    // One label per grouping column
+    GradeAggregate stats;
+};
+
+struct AggregateReport {
+    std::vector<GroupKey> keys;
+    std::vector<bool> numericKey;    // Column i holds numbers (year, semester, IIT course)
+    std::vector<AggregateGroup> groups;  // Ordered by the key columns
+    size_t students = 0;
+    unsigned long long enrollments = 0;
+    int threads = 0;
+    long long partialNs = 0;         // Per-thread partial aggregation
+    long long mergeNs = 0;           // Partition merge, labels and ordering
+    long long totalNs = 0;
+};
+
+// How each course type answers the course and semester keys
+template<typename CourseType>
+struct CourseGroupTraits;
+
+template<>
+struct CourseGroupTraits<IIITCourse> {
+    static constexpr bool numericCourse = false;
+    static constexpr bool hasSemester = true;
+    static uint64_t course(const IIITCourse& c) { return reinterpret_cast<uintptr_t>(&c.code.str()); }
+    static std::string courseLabel(uint64_t value) { return *reinterpret_cast<const std::string*>(value); }
+    static int semester(const IIITCourse& c) { return c.semester; }
+};
+
+template<>
+struct CourseGroupTraits<IITCourse> {
+    static constexpr bool numericCourse = true;
+    static constexpr bool hasSemester = false;
+    static uint64_t course(const IITCourse& c) { return static_cast<uint64_t>(static_cast<int64_t>(c.code)); }
+    static std::string courseLabel(uint64_t value) { return std::to_string(static_cast<int64_t>(value)); }
+    static int semester(const IITCourse&) { return 0; }
+};
+
+// Grade statistics of every enrollment (student x course), grouped by keys.
+// Partitioned parallel hash aggregation: each thread aggregates a slice of
+// the students into one hash table per partition (by key hash), then thread
+// p merges partition p of every thread, so no table is shared or locked.
+// threads = 0 picks min(hardware threads, students / MIN_STUDENTS_PER_THREAD).
+template<typename RollType, typename CourseType>
+class StudentAggregator {
+public:
+    static constexpr size_t MIN_STUDENTS_PER_THREAD = 16384;
+
+private:
+    using Traits = CourseGroupTraits<CourseType>;
+
+    std::vector<GroupKey> keys;
+    int courseColumn = -1;     // Tuple position of the course key, -1 = not grouped by course
+    int semesterColumn = -1;
+
+    static long long nsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    static void runThreads(int count, const std::function<void(int)>& work) {
+        if (count == 1) {
+            work(0);
+            return;
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < count; t++) threads.emplace_back(work, t);
+        for (auto& thread : threads) thread.join();
+    }
+
+    // Student columns (branch, year) of a group tuple; course columns stay 0
+    GroupTuple studentTuple(const Student<RollType, CourseType>& student) const {
+        GroupTuple tuple{};
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == GroupKey::Branch) tuple[i] = reinterpret_cast<uintptr_t>(student.getRecord()->branch);
+            else if (keys[i] == GroupKey::Year) tuple[i] = static_cast<uint64_t>(static_cast<int64_t>(student.getStartYear()));
+        }
+        return tuple;
+    }
+
+    // Fill in the course columns (course, semester) for one enrollment
+    void setCourseColumns(GroupTuple& tuple, const CourseType& course) const {
+        if (courseColumn >= 0) tuple[courseColumn] = Traits::course(course);
+        if (semesterColumn >= 0) {
+            tuple[semesterColumn] = static_cast<uint64_t>(static_cast<int64_t>(Traits::semester(course)));
+        }
+    }
+
+    std::string label(GroupKey key, uint64_t value) const {
+        switch (key) {
+            case GroupKey::Branch: return *reinterpret_cast<const std::string*>(value);
+            case GroupKey::Course: return Traits::courseLabel(value);
+            case GroupKey::Year:
+            case GroupKey::Semester: break;
+        }
+        return std::to_string(static_cast<int64_t>(value));
+    }
+
+    bool isNumeric(GroupKey key) const {
+        return key == GroupKey::Year || key == GroupKey::Semester ||
+               (key == GroupKey::Course && Traits::numericCourse);
+    }
+
+public:
+    // Throws invalid_argument for keys the course type cannot answer
+    explicit StudentAggregator(std::vector<GroupKey> groupKeys) : keys(std::move(groupKeys)) {
+        if (keys.size() > std::tuple_size<GroupTuple>::value) {
+            throw std::invalid_argument("At most 4 group keys");
+        }
+        for (GroupKey key : keys) {
+            if (key == GroupKey::Semester && !Traits::hasSemester) {
+                throw std::invalid_argument("Group key 'semester' needs courses with semesters (IIIT)");
+            }
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == GroupKey::Course) courseColumn = static_cast<int>(i);
+            if (keys[i] == GroupKey::Semester) semesterColumn = static_cast<int>(i);
+        }
+    }
+
+    AggregateReport run(const std::vector<Student<RollType, CourseType>>& students, int threads = 0) const {
+        ScopedTimer span("aggregate", "aggregate");
+        auto start = std::chrono::steady_clock::now();
+        AggregateReport report;
+        report.keys = keys;
+        for (GroupKey key : keys) report.numericKey.push_back(isNumeric(key));
+        report.students = students.size();
+
+        if (threads <= 0) {
+            int hardware = std::max(1u, std::thread::hardware_concurrency());
+            threads = static_cast<int>(std::min<size_t>(hardware, students.size() / MIN_STUDENTS_PER_THREAD));
+        }
+        threads = static_cast<int>(std::min<size_t>(threads, std::max<size_t>(students.size(), 1)));
+        threads = std::max(threads, 1);
+        report.threads = threads;
+        span.arg("threads", threads);
+        span.arg("students", static_cast<long long>(students.size()));
+
+        // partials[t][p]: thread t's groups whose hash falls in partition p
+        const int partitions = threads;
+        std::vector<std::vector<GroupTable>> partials(threads, std::vector<GroupTable>(partitions));
+        std::vector<unsigned long long> enrollments(threads, 0);
+        GroupTupleHash hash;
+        runThreads(threads, [&](int t) {
+            std::vector<GroupTable>& tables = partials[t];
+            size_t first = students.size() * t / threads;
+            size_t last = students.size() * (t + 1) / threads;
+            unsigned long long seen = 0;
+            auto groupOf = [&](const GroupTuple& tuple) -> GradeAggregate::Histogram& {
+                size_t h = hash(tuple);
+                // High bits pick the partition (without a division), low bits the slot
+                size_t partition = static_cast<size_t>(((h >> 32) * static_cast<uint64_t>(partitions)) >> 32);
+                return tables[partition].find(tuple, h);
+            };
+            auto bucket = [](int points) { return std::clamp(points, 0, GradeAggregate::MAX_POINTS); };
+            for (size_t i = first; i < last; i++) {
+                const auto& student = students[i];
+                const auto& courses = student.getCourses();
+                seen += courses.size();
+                if (courses.empty()) continue;
+                GroupTuple tuple = studentTuple(student);
+                if (courseColumn < 0 && semesterColumn < 0) {
+                    // Every enrollment of the student lands in the same group
+                    GradeAggregate::Histogram& group = groupOf(tuple);
+                    for (const auto& course : courses) group[bucket(course.getGradePoints())]++;
+                    continue;
+                }
+                for (const auto& course : courses) {
+                    setCourseColumns(tuple, course);
+                    groupOf(tuple)[bucket(course.getGradePoints())]++;
+                }
+            }
+            enrollments[t] = seen;
+        });
+        report.partialNs = nsSince(start);
+        for (unsigned long long count : enrollments) report.enrollments += count;
+
+        // Thread p owns partition p: merge it across threads, then label it
+        std::vector<std::vector<AggregateGroup>> merged(partitions);
+        runThreads(partitions, [&](int p) {
+            GroupTable table = std::move(partials[0][p]);
+            for (int t = 1; t < threads; t++) {
+                const GroupTable& part = partials[t][p];
+                for (size_t g = 0; g < part.size(); g++) {
+                    GradeAggregate::Histogram& target = table.find(part.keyAt(g), hash(part.keyAt(g)));
+                    const GradeAggregate::Histogram& counts = part.histogramAt(g);
+                    for (size_t b = 0; b < counts.size(); b++) target[b] += counts[b];
+                }
+                GroupTable().swap(partials[t][p]);
+            }
+            merged[p].reserve(table.size());
+            for (size_t g = 0; g < table.size(); g++) {
+                AggregateGroup group{table.keyAt(g), {}, GradeAggregate::fromHistogram(table.histogramAt(g))};
+                for (size_t i = 0; i < keys.size(); i++) group.key.push_back(label(keys[i], table.keyAt(g)[i]));
+                merged[p].push_back(std::move(group));
+            }
+        });
+
+        for (auto& part : merged) {
+            std::move(part.begin(), part.end(), std::back_inserter(report.groups));
+        }
+        std::sort(report.groups.begin(), report.groups.end(), [&](const AggregateGroup& a, const AggregateGroup& b) {
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (a.tuple[i] == b.tuple[i]) continue;
+                if (report.numericKey[i]) {
+                    return static_cast<int64_t>(a.tuple[i]) < static_cast<int64_t>(b.tuple[i]);
+                }
+                return a.key[i] < b.key[i];
+            }
+            return false;
+        });
+        report.totalNs = nsSince(start);
+        report.mergeNs = report.totalNs - report.partialNs;
+        return report;
+    }
+};
+
+#endif // AGGREGATION_H
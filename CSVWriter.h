@@ -0,0 +1,135 @@
+#ifndef CSV_WRITER_H
+#define CSV_WRITER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
+#include "Metrics.h"
+#include "PackedRoll.h"
+
+// Append helpers used by row formatters - std::to_chars, no locale, no flush
+inline void appendCSVField(std::string& out, const std::string& value) {
+    out.append(value);
+}
+
+inline void appendCSVField(std::string& out, const char* value) {
+    out.append(value);
+}
+
+inline void appendCSVField(std::string& out, char value) {
+    out.push_back(value);
+}
+
+inline void appendCSVField(std::string& out, const PackedRoll& value) {
+    char chars[PackedRoll::MAX_LENGTH];
+    std::string_view text = value.view(chars);
+    out.append(text.data(), text.size());
+}
+
+template<typename Integer>
+inline void appendCSVInteger(std::string& out, Integer value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+inline void appendCSVField(std::string& out, int value) { appendCSVInteger(out, value); }
+inline void appendCSVField(std::string& out, unsigned int value) { appendCSVInteger(out, value); }
+inline void appendCSVField(std::string& out, long value) { appendCSVInteger(out, value); }
+inline void appendCSVField(std::string& out, unsigned long value) { appendCSVInteger(out, value); }
+inline void appendCSVField(std::string& out, long long value) { appendCSVInteger(out, value); }
+inline void appendCSVField(std::string& out, unsigned long long value) { appendCSVInteger(out, value); }
+
+// Writes CSV rows through large in-memory buffers instead of one
+// stream flush per row. Rows are cut into fixed-size chunks; each round
+// formats one chunk per thread in parallel, then the chunk buffers are
+// written to the file in row order. Memory use is bounded by
+// numThreads * chunkRows rows, independent of the total row count.
+class ParallelCSVWriter {
+private:
+    int numThreads;
+    size_t chunkRows;
+    std::vector<std::string> buffers; // One reusable buffer per thread
+
+public:
+    ParallelCSVWriter(int threads = 0, size_t rowsPerChunk = 16384)
+        : numThreads(threads), chunkRows(rowsPerChunk) {
+        if (numThreads <= 0) {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (chunkRows == 0) chunkRows = 1;
+    }
+
+    // formatRow(std::string& out, size_t row) appends row `row`, including
+    // its trailing newline. Throws runtime_error on open/write failure.
+    template<typename Formatter>
+    size_t write(const std::string& filename, const std::string& header,
+                 size_t rowCount, Formatter formatRow) {
+        ScopedTimer span("export.csv", "export");
+        span.arg("rows", (long long)rowCount);
+        std::ofstream outFile(filename, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            throw std::runtime_error("Could not create file: " + filename);
+        }
+
+        size_t bytesWritten = 0;
+        outFile.write(header.data(), header.size());
+        outFile.put('\n');
+        bytesWritten += header.size() + 1;
+
+        size_t totalChunks = (rowCount + chunkRows - 1) / chunkRows;
+        buffers.resize(numThreads);
+
+        for (size_t firstChunk = 0; firstChunk < totalChunks; firstChunk += numThreads) {
+            size_t roundChunks = std::min<size_t>(numThreads, totalChunks - firstChunk);
+
+            auto formatChunk = [&](size_t slot) {
+                ScopedTimer chunkSpan("export.format_chunk", "export");
+                chunkSpan.arg("chunk", (long long)(firstChunk + slot));
+                std::string& buffer = buffers[slot];
+                buffer.clear();
+                size_t begin = (firstChunk + slot) * chunkRows;
+                size_t end = std::min(begin + chunkRows, rowCount);
+                for (size_t row = begin; row < end; row++) {
+                    formatRow(buffer, row);
+                }
+            };
+
+            // Small rounds are formatted inline - spawning costs more than it saves
+            if (roundChunks == 1) {
+                formatChunk(0);
+            } else {
+                std::vector<std::thread> workers;
+                for (size_t slot = 1; slot < roundChunks; slot++) {
+                    workers.emplace_back(formatChunk, slot);
+                }
+                formatChunk(0);
+                for (auto& t : workers) {
+                    t.join();
+                }
+            }
+
+            for (size_t slot = 0; slot < roundChunks; slot++) {
+                outFile.write(buffers[slot].data(), buffers[slot].size());
+                bytesWritten += buffers[slot].size();
+            }
+
+            if (!outFile) {
+                throw std::runtime_error("Write failed: " + filename);
+            }
+        }
+
+        outFile.close();
+        span.arg("bytes", (long long)bytesWritten);
+        if (outFile.fail()) {
+            throw std::runtime_error("Could not finish writing: " + filename);
+        }
+        return bytesWritten;
+    }
+};
+
+#endif // CSV_WRITER_H
@@ -0,0 +1,196 @@
+#ifndef CONCURRENT_STUDENT_MANAGER_H
+#define CONCURRENT_STUDENT_MANAGER_H
+
+#include "Student.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+// Thread-safe student store for serving lookups while a loader appends
+// (`serve --ingest`). Readers call snapshot() and get an immutable, consistent
+// view that stays valid for as long as they hold it; they never wait for the
+// writer's mutex or for a publish to finish. Writers queue appends and publish
+// them in batches: a new segment is built off to the side and swapped in with
+// one atomic shared_ptr store (RCU-style - the writer reclaims old snapshots
+// once no reader holds them any more).
+// Not lock-free: libstdc++ implements std::atomic_load/atomic_store on a
+// shared_ptr with a small internal mutex pool (std::atomic_is_lock_free is
+// false), so each snapshot() briefly locks around the pointer copy.
+template<typename RollType, typename CourseType>
+class ConcurrentStudentManager {
+public:
+    using StudentType = Student<RollType, CourseType>;
+
+    // A published run of students with its own roll lookup; never modified
+    struct Segment {
+        size_t base;                                  // Global index of students[0]
+        std::vector<StudentType> students;
+        std::unordered_map<RollType, int> rollIndex;  // First occurrence of each roll
+    };
+
+    // Consistent view of every student published so far
+    class Snapshot {
+    private:
+        std::vector<std::shared_ptr<const Segment>> segments;
+        size_t total;
+        uint64_t version;
+
+        friend class ConcurrentStudentManager;
+
+    public:
+        Snapshot() : total(0), version(0) {}
+
+        size_t size() const { return total; }
+
+        // Number of publishes this view includes
+        uint64_t getVersion() const { return version; }
+
+        size_t getSegmentCount() const { return segments.size(); }
+
+        // Student by global index (insertion order), 0 <= index < size()
+        const StudentType& getStudent(size_t index) const {
+            auto it = std::upper_bound(segments.begin(), segments.end(), index,
+                [](size_t value, const std::shared_ptr<const Segment>& seg) {
+                    return value < seg->base;
+                });
+            const Segment& seg = **(it - 1);
+            return seg.students[index - seg.base];
+        }
+
+        // Earliest student with this roll number, or nullptr; O(segments)
+        const StudentType* findByRoll(const RollType& roll) const {
+            for (const auto& seg : segments) {
+                auto it = seg->rollIndex.find(roll);
+                if (it != seg->rollIndex.end()) {
+                    return &seg->students[it->second];
+                }
+            }
+            return nullptr;
+        }
+
+        // Visit students in insertion order
+        template<typename Visitor>
+        void forEach(Visitor visit) const {
+            for (const auto& seg : segments) {
+                for (const auto& student : seg->students) {
+                    visit(student);
+                }
+            }
+        }
+
+        // Global indices of students with a grade >= minGrade in some course
+        std::vector<size_t> findHighGradeStudents(int minGrade) const {
+            std::vector<size_t> results;
+            for (const auto& seg : segments) {
+                for (size_t i = 0; i < seg->students.size(); i++) {
+                    if (seg->students[i].hasGradeAboveInCourse(minGrade)) {
+                        results.push_back(seg->base + i);
+                    }
+                }
+            }
+            return results;
+        }
+    };
+
+private:
+    std::shared_ptr<const Snapshot> current;  // Only accessed via std::atomic_load/atomic_store
+    std::mutex writerMutex;                   // Serialises writers; snapshot() does not take it
+    std::vector<StudentType> pending;         // Appended but not yet visible
+    std::vector<std::shared_ptr<const Snapshot>> retired; // Superseded views readers may still hold
+    size_t batchSize;
+
+    static std::shared_ptr<const Segment> buildSegment(size_t base, std::vector<StudentType> students) {
+        auto seg = std::make_shared<Segment>();
+        seg->base = base;
+        seg->students = std::move(students);
+        seg->rollIndex.reserve(seg->students.size());
+        for (size_t i = 0; i < seg->students.size(); i++) {
+            seg->rollIndex.emplace(seg->students[i].getRollNumber(), static_cast<int>(i));
+        }
+        return seg;
+    }
+
+    // Must hold writerMutex. Segments are merged like a binary counter (a new
+    // segment absorbs its predecessor while it is at least as large), which
+    // keeps O(log n) segments for lookups and O(log n) copies per student.
+    void publishLocked() {
+        if (pending.empty()) return;
+
+        std::shared_ptr<const Snapshot> old = std::atomic_load(&current);
+        auto next = std::make_shared<Snapshot>();
+        next->segments = old->segments;
+        next->total = old->total + pending.size();
+        next->version = old->version + 1;
+
+        std::vector<StudentType> batch;
+        batch.swap(pending);
+        while (!next->segments.empty() && next->segments.back()->students.size() <= batch.size()) {
+            const Segment& prev = *next->segments.back();
+            std::vector<StudentType> merged;
+            merged.reserve(prev.students.size() + batch.size());
+            merged.insert(merged.end(), prev.students.begin(), prev.students.end());
+            merged.insert(merged.end(), std::make_move_iterator(batch.begin()),
+                          std::make_move_iterator(batch.end()));
+            batch.swap(merged);
+            next->segments.pop_back();
+        }
+        size_t base = next->total - batch.size();
+        next->segments.push_back(buildSegment(base, std::move(batch)));
+
+        std::atomic_store(&current, std::shared_ptr<const Snapshot>(std::move(next)));
+
+        // Keep superseded views alive until no reader holds them, so that
+        // freeing merged-away segments happens here rather than on a reader
+        retired.push_back(std::move(old));
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+            [](const std::shared_ptr<const Snapshot>& view) { return view.use_count() == 1; }),
+            retired.end());
+    }
+
+public:
+    explicit ConcurrentStudentManager(size_t appendBatchSize = 1024)
+        : current(std::make_shared<const Snapshot>()), batchSize(std::max<size_t>(1, appendBatchSize)) {}
+
+    ConcurrentStudentManager(const ConcurrentStudentManager&) = delete;
+    ConcurrentStudentManager& operator=(const ConcurrentStudentManager&) = delete;
+
+    // Current published view; hold on to it for consistent multi-step reads
+    std::shared_ptr<const Snapshot> snapshot() const {
+        return std::atomic_load(&current);
+    }
+
+    // Queue a student; becomes visible once a full batch is published
+    void addStudent(StudentType student) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        pending.push_back(std::move(student));
+        if (pending.size() >= batchSize) publishLocked();
+    }
+
+    // Append and publish many students as one atomic step
+    void addStudents(std::vector<StudentType> students) {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        if (pending.empty()) {
+            pending = std::move(students);
+        } else {
+            pending.insert(pending.end(), std::make_move_iterator(students.begin()),
+                           std::make_move_iterator(students.end()));
+        }
+        publishLocked();
+    }
+
+    // Make every queued student visible
+    void publish() {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        publishLocked();
+    }
+
+    size_t getPublishedStudents() const {
+        return snapshot()->size();
+    }
+};
+
+#endif // CONCURRENT_STUDENT_MANAGER_H
@@ -0,0 +1,131 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// NUMA nodes and the CPUs on each, read from /sys/devices/system/node.
+// Only CPUs this process may run on (sched_getaffinity) are listed. A
+// machine without the sysfs tree (or a single-node one) is one node with
+// every allowed CPU, so pinning still works and NUMA placement is a no-op.
+class CpuTopology {
+private:
+    std::vector<std::vector<int>> nodes;  // CPU ids per node, ascending
+
+    static std::vector<int> allowedCpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty()) {
+            unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned int cpu = 0; cpu < count; cpu++) cpus.push_back(static_cast<int>(cpu));
+        }
+        return cpus;
+    }
+
+public:
+    // Parse a sysfs CPU (or node) list such as "0-3,8-11"; malformed parts are skipped
+    static std::vector<int> parseCpuList(const std::string& text) {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find(',', pos);
+            if (end == std::string::npos) end = text.size();
+            std::string part = text.substr(pos, end - pos);
+            while (!part.empty() && std::isspace(static_cast<unsigned char>(part.back()))) part.pop_back();
+            try {
+                size_t dash = part.find('-');
+                int first = std::stoi(part.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(part.substr(dash + 1));
+                for (int cpu = first; cpu <= last && cpu >= 0; cpu++) cpus.push_back(cpu);
+            } catch (const std::exception&) {
+                // Not a number or range - ignore this part
+            }
+            pos = end + 1;
+        }
+        return cpus;
+    }
+
+    // Read the online node ids and each node<N>/cpulist under nodeRoot
+    static CpuTopology detect(const std::string& nodeRoot = "/sys/devices/system/node") {
+        CpuTopology topology;
+        std::vector<int> allowed = allowedCpus();
+        std::ifstream online(nodeRoot + "/online");
+        std::string line;
+        if (online && std::getline(online, line)) {
+            for (int node : parseCpuList(line)) {
+                std::ifstream in(nodeRoot + "/node" + std::to_string(node) + "/cpulist");
+                if (!in || !std::getline(in, line)) continue;
+                std::vector<int> cpus;
+                for (int cpu : parseCpuList(line)) {
+                    if (std::binary_search(allowed.begin(), allowed.end(), cpu)) cpus.push_back(cpu);
+                }
+                if (!cpus.empty()) topology.nodes.push_back(std::move(cpus));  // Memory-only nodes dropped
+            }
+        }
+        if (topology.nodes.empty()) topology.nodes.push_back(allowed);
+        return topology;
+    }
+
+    // Topology of this machine, detected once
+    static const CpuTopology& system() {
+        static const CpuTopology topology = detect();
+        return topology;
+    }
+
+    int nodeCount() const { return static_cast<int>(nodes.size()); }
+    const std::vector<int>& cpusOfNode(int node) const { return nodes[node]; }
+
+    int cpuCount() const {
+        size_t count = 0;
+        for (const auto& cpus : nodes) count += cpus.size();
+        return static_cast<int>(count);
+    }
+
+    // Node of cpu, -1 if it is not one of ours
+    int nodeOf(int cpu) const {
+        for (size_t node = 0; node < nodes.size(); node++) {
+            if (std::binary_search(nodes[node].begin(), nodes[node].end(), cpu)) return static_cast<int>(node);
+        }
+        return -1;
+    }
+
+    // CPU for each of `threads` workers. CPUs are taken evenly from the
+    // node-ordered list, so consecutive workers (which own neighbouring
+    // parts of the data) share a node and the nodes get equal shares.
+    // More workers than CPUs wrap around.
+    std::vector<int> placement(int threads) const {
+        std::vector<int> ordered;
+        for (const auto& cpus : nodes) ordered.insert(ordered.end(), cpus.begin(), cpus.end());
+        std::vector<int> cpuOfThread(std::max(threads, 0));
+        size_t count = ordered.size();
+        for (int t = 0; t < threads; t++) {
+            size_t slot = threads <= static_cast<int>(count) ? static_cast<size_t>(t) * count / threads : t % count;
+            cpuOfThread[t] = ordered[slot];
+        }
+        return cpuOfThread;
+    }
+
+    // Bind the calling thread to cpu; false if the kernel refused
+    static bool pinCurrentThread(int cpu) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+};
+
+#endif // CPU_TOPOLOGY_H
@@ -0,0 +1,517 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <string>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <unistd.h>
+#include "StudentIO.h"
+#include "SortingThreads.h"
+#include "Metrics.h"
+
+// ============================================================================
+// BINARY RUN FORMAT
+// ============================================================================
+//
+// Spilled runs are a sequence of entries, native byte order (runs never
+// outlive the process that wrote them). An entry is a student record, a
+// twin flag (char) and, if the flag is set, the record of the other
+// system's student from the same CSV row. A record is
+//   roll, name (u32 length + bytes), branch, year (i32), course count (u32),
+//   courses. Rolls are u32 for IIT, the raw PackedRoll bytes for IIIT
+//   (a long roll's interned text pointer stays valid for the process);
+//   IIIT courses are code, semester (i32), grade (char); IIT courses are
+//   code (i32), grade (char).
+
+inline void appendRunBytes(std::string& out, const void* data, size_t size) {
+    out.append(static_cast<const char*>(data), size);
+}
+
+inline void appendRunValue(std::string& out, uint32_t value) { appendRunBytes(out, &value, sizeof(value)); }
+inline void appendRunValue(std::string& out, int32_t value) { appendRunBytes(out, &value, sizeof(value)); }
+inline void appendRunValue(std::string& out, char value) { out.push_back(value); }
+
+inline void appendRunValue(std::string& out, const std::string& value) {
+    appendRunValue(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+inline void appendRunValue(std::string& out, const IIITCourse& course) {
+    appendRunValue(out, course.code);
+    appendRunValue(out, static_cast<int32_t>(course.semester));
+    appendRunValue(out, course.grade);
+}
+
+inline void appendRunValue(std::string& out, const IITCourse& course) {
+    appendRunValue(out, static_cast<int32_t>(course.code));
+    appendRunValue(out, course.grade);
+}
+
+template<typename RollType, typename CourseType>
+void appendRunRecord(std::string& out, const Student<RollType, CourseType>& student) {
+    if constexpr (std::is_same<RollType, std::string>::value) {
+        appendRunValue(out, student.getRollNumber());
+    } else if constexpr (std::is_same<RollType, PackedRoll>::value) {
+        appendRunBytes(out, &student.getRollNumber(), sizeof(PackedRoll));
+    } else {
+        appendRunValue(out, static_cast<uint32_t>(student.getRollNumber()));
+    }
+    appendRunValue(out, student.getName());
+    appendRunValue(out, student.getBranch());
+    appendRunValue(out, static_cast<int32_t>(student.getStartYear()));
+    appendRunValue(out, static_cast<uint32_t>(student.getCourses().size()));
+    for (const auto& course : student.getCourses()) {
+        appendRunValue(out, course);
+    }
+}
+
+// Appends to a run file through a buffer of ioBytes
+class RunFileWriter {
+private:
+    std::ofstream file;
+    std::string path;
+    std::string buffer;
+    size_t flushAt;
+    unsigned long long written;
+
+public:
+    RunFileWriter(const std::string& filename, size_t ioBytes)
+        : file(filename, std::ios::binary | std::ios::trunc), path(filename),
+          flushAt(std::max<size_t>(ioBytes, 4096)), written(0) {
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not create file: " + filename);
+        }
+        buffer.reserve(flushAt + 1024);
+    }
+
+    std::string& out() { return buffer; }
+
+    // Call after appending a record
+    void maybeFlush() {
+        if (buffer.size() >= flushAt) flush();
+    }
+
+    void flush() {
+        file.write(buffer.data(), buffer.size());
+        written += buffer.size();
+        buffer.clear();
+        if (!file) {
+            throw std::runtime_error("Write failed: " + path);
+        }
+    }
+
+    // Returns total bytes written; throws runtime_error on failure
+    unsigned long long close() {
+        flush();
+        file.close();
+        if (file.fail()) {
+            throw std::runtime_error("Could not finish writing: " + path);
+        }
+        return written;
+    }
+};
+
+// Reads records back from a run file through a buffer of ioBytes
+class RunFileReader {
+private:
+    std::ifstream file;
+    std::string path;
+    std::vector<char> buffer;
+    size_t pos;
+    size_t len;
+
+    bool refill() {
+        if (pos < len) {
+            std::memmove(buffer.data(), buffer.data() + pos, len - pos);
+        }
+        len -= pos;
+        pos = 0;
+        file.read(buffer.data() + len, buffer.size() - len);
+        len += static_cast<size_t>(file.gcount());
+        return len > 0;
+    }
+
+    void readBytes(void* dst, size_t size) {
+        char* out = static_cast<char*>(dst);
+        while (size > 0) {
+            if (pos == len && !refill()) {
+                throw std::runtime_error("Truncated run file: " + path);
+            }
+            size_t take = std::min(size, len - pos);
+            std::memcpy(out, buffer.data() + pos, take);
+            pos += take;
+            out += take;
+            size -= take;
+        }
+    }
+
+    template<typename T>
+    T readValue() {
+        T value;
+        readBytes(&value, sizeof(value));
+        return value;
+    }
+
+    std::string readString() {
+        uint32_t size = readValue<uint32_t>();
+        std::string value(size, '\0');
+        readBytes(&value[0], size);
+        return value;
+    }
+
+    void readCourse(IIITCourse& course) {
+        course.code = readString();
+        course.semester = readValue<int32_t>();
+        course.grade = readValue<char>();
+    }
+
+    void readCourse(IITCourse& course) {
+        course.code = readValue<int32_t>();
+        course.grade = readValue<char>();
+    }
+
+public:
+    RunFileReader(const std::string& filename, size_t ioBytes)
+        : file(filename, std::ios::binary), path(filename),
+          buffer(std::max<size_t>(ioBytes, 4096)), pos(0), len(0) {
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open run file: " + filename);
+        }
+    }
+
+    // Whether every record has been read
+    bool atEnd() {
+        return pos == len && !refill();
+    }
+
+    char readFlag() {
+        return readValue<char>();
+    }
+
+    // Next record; throws runtime_error if the run ends inside it
+    template<typename RollType, typename CourseType>
+    void read(Student<RollType, CourseType>& student) {
+        RollType roll;
+        if constexpr (std::is_same<RollType, std::string>::value) {
+            roll = readString();
+        } else if constexpr (std::is_same<RollType, PackedRoll>::value) {
+            readBytes(&roll, sizeof(PackedRoll));
+        } else {
+            roll = readValue<uint32_t>();
+        }
+        std::string name = readString();
+        std::string branch = readString();
+        int year = readValue<int32_t>();
+        student = Student<RollType, CourseType>(std::move(roll), name, branch, year);
+
+        uint32_t courseCount = readValue<uint32_t>();
+        for (uint32_t c = 0; c < courseCount; c++) {
+            CourseType course;
+            readCourse(course);
+            student.addCourse(course);
+        }
+    }
+};
+
+// ============================================================================
+// EXTERNAL MERGE SORT
+// ============================================================================
+
+struct ExternalSortOptions {
+    size_t memoryBytes = 256u << 20;   // Budget for in-memory chunks and merge buffers
+    size_t ioBufferBytes = 1u << 20;   // Per run file / output buffer
+    int threads = 0;                   // Threads sorting each chunk, 0 = auto
+    std::string tempDir;               // Run files go here; empty = the output file's directory
+};
+
+struct ExternalSortReport {
+    size_t records = 0;
+    int errors = 0;                    // Rejected input rows
+    size_t runs = 0;                   // Initial sorted runs spilled
+    int mergePasses = 0;               // Intermediate passes before the final merge
+    unsigned long long spillBytes = 0; // Bytes written to run files, all passes
+    long long runPhaseNs = 0;          // Read + parse + sort + spill
+    long long mergePhaseNs = 0;
+    long long totalNs = 0;
+};
+
+// Sorts a roster larger than RAM: the CSV is read in chunks that fit half
+// the memory budget (the rest is scratch for the parallel sort), each chunk
+// is sorted with SortingThreadsManager and spilled as a binary run, and the
+// runs are k-way merged into a CSV in the export format. If there are more
+// runs than merge buffers fit in the budget, extra merge passes combine
+// them into longer runs first. Ties keep input order.
+template<typename RollType, typename CourseType, typename Compare = std::less<Student<RollType, CourseType>>>
+class ExternalSorter {
+public:
+    using StudentType = Student<RollType, CourseType>;
+    // The other system's student of the same CSV row
+    using TwinType = typename std::conditional<std::is_same<CourseType, IIITCourse>::value,
+                                               IITStudent, IIITStudent>::type;
+
+    // A student plus its twin, so the output rows carry both course columns
+    // like exportSortedCSV
+    struct SortEntry {
+        StudentType student;
+        TwinType twin;
+        bool hasTwin = false;
+    };
+
+private:
+    ExternalSortOptions options;
+    Compare comp;
+    std::vector<std::string> tempFiles;  // Removed by the destructor
+    std::string runDir;
+    int nextRunId;
+
+    std::string newRunPath() {
+        std::string path = runDir + "/erp_extsort_" + std::to_string(::getpid()) + "_" +
+                           std::to_string(nextRunId++) + ".run";
+        tempFiles.push_back(path);
+        return path;
+    }
+
+    void removeRun(const std::string& path) {
+        std::remove(path.c_str());
+        tempFiles.erase(std::find(tempFiles.begin(), tempFiles.end(), path));
+    }
+
+    // Rough heap footprint of one parsed entry beyond sizeof(SortEntry);
+    // the twin shares the student's name/branch record
+    static size_t estimateBytes(const SortEntry& entry) {
+        const StudentType& student = entry.student;
+        size_t bytes = student.getName().capacity() + student.getBranch().capacity();
+        if (!student.getCourses().isInline()) {
+            bytes += student.getCourses().capacity() * sizeof(CourseType);
+        }
+        if (!entry.twin.getCourses().isInline()) {
+            bytes += entry.twin.getCourses().capacity() * sizeof(entry.twin.getCourses()[0]);
+        }
+        if constexpr (std::is_same<RollType, std::string>::value) {
+            bytes += student.getRollNumber().capacity();
+        }
+        return bytes;
+    }
+
+    static void appendRunEntry(std::string& out, const SortEntry& entry) {
+        appendRunRecord(out, entry.student);
+        appendRunValue(out, static_cast<char>(entry.hasTwin));
+        if (entry.hasTwin) appendRunRecord(out, entry.twin);
+    }
+
+    // Next entry of a run, or false at its end
+    static bool readRunEntry(RunFileReader& reader, SortEntry& entry) {
+        if (reader.atEnd()) return false;
+        reader.read(entry.student);
+        entry.hasTwin = reader.readFlag() != 0;
+        if (entry.hasTwin) reader.read(entry.twin);
+        return true;
+    }
+
+    bool entryLess(const SortEntry& a, const SortEntry& b) const {
+        return comp(a.student, b.student);
+    }
+
+    std::string spillRun(std::vector<SortEntry>& chunk, SortingThreadsManager& sorter,
+                         ExternalSortReport& report) {
+        ScopedTimer span("extsort.spill_run", "sort");
+        span.arg("records", (long long)chunk.size());
+        sorter.parallelSort(chunk, options.threads,
+            [this](const SortEntry& a, const SortEntry& b) { return entryLess(a, b); });
+
+        std::string path = newRunPath();
+        RunFileWriter writer(path, options.ioBufferBytes);
+        for (const auto& entry : chunk) {
+            appendRunEntry(writer.out(), entry);
+            writer.maybeFlush();
+        }
+        report.spillBytes += writer.close();
+        chunk.clear();
+        return path;
+    }
+
+    // Merge runs in order, handing each entry to emit(entry)
+    template<typename Emit>
+    void mergeRuns(const std::vector<std::string>& runs, Emit emit) {
+        std::vector<std::unique_ptr<RunFileReader>> readers;
+        std::vector<SortEntry> heads(runs.size());
+        for (const auto& path : runs) {
+            readers.push_back(std::make_unique<RunFileReader>(path, options.ioBufferBytes));
+        }
+
+        // Heap of run ids; the top is the smallest head, ties by run id
+        auto after = [&](size_t a, size_t b) {
+            if (entryLess(heads[b], heads[a])) return true;
+            if (entryLess(heads[a], heads[b])) return false;
+            return a > b;
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+        for (size_t r = 0; r < runs.size(); r++) {
+            if (readRunEntry(*readers[r], heads[r])) heap.push(r);
+        }
+        while (!heap.empty()) {
+            size_t r = heap.top();
+            heap.pop();
+            emit(heads[r]);
+            if (readRunEntry(*readers[r], heads[r])) heap.push(r);
+        }
+    }
+
+public:
+    explicit ExternalSorter(const ExternalSortOptions& opts = ExternalSortOptions(), Compare compare = Compare())
+        : options(opts), comp(std::move(compare)), nextRunId(0) {
+        options.ioBufferBytes = std::max<size_t>(options.ioBufferBytes, 4096);
+        options.memoryBytes = std::max<size_t>(options.memoryBytes, 4 * options.ioBufferBytes);
+    }
+
+    ~ExternalSorter() {
+        for (const auto& path : tempFiles) {
+            std::remove(path.c_str());
+        }
+    }
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    /**
+     * Sort the students of one system in a CSV file into outputFile
+     * Rows are routed like loadStudentsFromStream: IIIT takes every valid
+     * row, IIT only numeric rolls. Throws runtime_error on I/O failure
+     */
+    ExternalSortReport sortFile(const std::string& inputFile, const std::string& outputFile) {
+        ScopedTimer span("extsort", "sort");
+        auto start = std::chrono::steady_clock::now();
+        ExternalSortReport report;
+        runDir = options.tempDir;
+        if (runDir.empty()) {
+            size_t slash = outputFile.find_last_of('/');
+            runDir = slash == std::string::npos ? "." : outputFile.substr(0, slash == 0 ? 1 : slash);
+        }
+
+        std::ifstream in(inputFile);
+        if (!in.is_open()) {
+            throw std::runtime_error("Could not open file: " + inputFile);
+        }
+        std::vector<char> inputBuffer(options.ioBufferBytes);
+        in.rdbuf()->pubsetbuf(inputBuffer.data(), inputBuffer.size());
+
+        std::string line;
+        if (!std::getline(in, line)) {
+            throw std::runtime_error("File is empty or cannot be read");
+        }
+
+        // Phase 1: memory-bounded chunks -> sorted binary runs
+        SortingThreadsManager sorter;
+        sorter.setVerbose(false);
+        sorter.setLogFile("");
+        std::vector<std::string> runs;
+        std::vector<SortEntry> chunk;
+        size_t chunkBytes = 0;
+        size_t chunkBudget = options.memoryBytes / 2;
+        int lineNumber = 1;
+
+        // A row yields this system's student and possibly its twin
+        SortEntry entry;
+        bool haveStudent = false;
+        auto keep = [&](auto&& student) {
+            using Parsed = typename std::decay<decltype(student)>::type;
+            if constexpr (std::is_same<Parsed, StudentType>::value) {
+                entry.student = std::move(student);
+                haveStudent = true;
+            } else if constexpr (std::is_same<Parsed, TwinType>::value) {
+                entry.twin = std::move(student);
+                entry.hasTwin = true;
+            }
+        };
+        while (std::getline(in, line)) {
+            lineNumber++;
+            RowOutcome outcome = parseStudentRow(line, lineNumber,
+                [&](IIITStudent&& student) { keep(std::move(student)); },
+                [&](IITStudent&& student) { keep(std::move(student)); });
+            report.errors += outcome.errors;
+            if (haveStudent) {
+                chunkBytes += estimateBytes(entry);
+                chunk.push_back(std::move(entry));
+                report.records++;
+            }
+            entry = SortEntry();
+            haveStudent = false;
+
+            // Records held, not chunk.capacity(): the vector keeps its
+            // capacity across spills, and counting it would shrink every
+            // later chunk to the slack the first one left
+            if (chunkBytes + chunk.size() * sizeof(SortEntry) >= chunkBudget) {
+                runs.push_back(spillRun(chunk, sorter, report));
+                chunkBytes = 0;
+            }
+        }
+        if (!chunk.empty()) {
+            runs.push_back(spillRun(chunk, sorter, report));
+        }
+        std::vector<SortEntry>().swap(chunk);
+        report.runs = runs.size();
+        report.runPhaseNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        // Phase 2: merge. Each open run holds one I/O buffer; keep one for the output
+        auto mergeStart = std::chrono::steady_clock::now();
+        size_t fanIn = std::max<size_t>(2, options.memoryBytes / options.ioBufferBytes - 1);
+        while (runs.size() > fanIn) {
+            ScopedTimer passSpan("extsort.merge_pass", "sort");
+            std::vector<std::string> nextRuns;
+            for (size_t first = 0; first < runs.size(); first += fanIn) {
+                std::vector<std::string> group(runs.begin() + first,
+                                               runs.begin() + std::min(first + fanIn, runs.size()));
+                if (group.size() == 1) {
+                    nextRuns.push_back(group[0]);
+                    continue;
+                }
+                std::string path = newRunPath();
+                RunFileWriter writer(path, options.ioBufferBytes);
+                mergeRuns(group, [&](const SortEntry& merged) {
+                    appendRunEntry(writer.out(), merged);
+                    writer.maybeFlush();
+                });
+                report.spillBytes += writer.close();
+                for (const auto& done : group) removeRun(done);
+                nextRuns.push_back(path);
+            }
+            runs.swap(nextRuns);
+            report.mergePasses++;
+        }
+
+        {
+            ScopedTimer finalSpan("extsort.final_merge", "sort");
+            RunFileWriter output(outputFile, options.ioBufferBytes);
+            output.out().append(studentCSVHeader());
+            output.out().push_back('\n');
+            mergeRuns(runs, [&](const SortEntry& merged) {
+                appendStudentRow(output.out(), merged.student, merged.hasTwin ? &merged.twin : nullptr);
+                output.maybeFlush();
+            });
+            output.close();
+        }
+        for (const auto& done : runs) removeRun(done);
+
+        report.mergePhaseNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - mergeStart).count();
+        report.totalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        span.arg("records", (long long)report.records);
+        span.arg("runs", (long long)report.runs);
+        return report;
+    }
+};
+
+#endif // EXTERNAL_SORT_H
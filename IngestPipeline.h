@@ -0,0 +1,383 @@
+#ifndef INGEST_PIPELINE_H
+#define INGEST_PIPELINE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <fstream>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <condition_variable>
+#include "StudentIO.h"
+#include "SearchIndex.h"
+#include "Metrics.h"
+
+// Fixed-capacity blocking queue connecting two pipeline stages
+template<typename T>
+class BoundedQueue {
+private:
+    std::mutex lock;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed;
+
+public:
+    explicit BoundedQueue(size_t maxItems) : capacity(std::max<size_t>(1, maxItems)), closed(false) {}
+
+    // Blocks while full; returns false if the queue was closed
+    bool push(T item) {
+        std::unique_lock<std::mutex> guard(lock);
+        notFull.wait(guard, [this] { return closed || items.size() < capacity; });
+        if (closed) return false;
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks while empty; returns false once closed and drained
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> guard(lock);
+        notEmpty.wait(guard, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Wake every waiter; pending items can still be popped
+    void close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
+
+struct IngestOptions {
+    int parserThreads = 0;     // 0 = hardware concurrency
+    size_t batchRows = 4096;   // Lines per batch handed to a parser
+    size_t queueDepth = 0;     // Batches buffered per queue, 0 = 2 per parser
+};
+
+// Busy time per stage; with the stages overlapped, totalNs tracks the
+// slowest stage rather than their sum
+struct IngestReport {
+    LoadResult load;
+    int parserThreads = 0;
+    size_t batches = 0;
+    size_t iiitRuns = 0;
+    size_t iitRuns = 0;
+    long long readNs = 0;       // Reader: file I/O and line splitting
+    long long parseNs = 0;      // Parsers: row parsing + run sorting, summed over threads
+    long long assembleNs = 0;   // Assembler: appends + index postings
+    long long mergeNs = 0;      // Final k-way merge of the sorted runs
+    long long totalNs = 0;
+};
+
+// Streaming CSV ingest: one reader thread cuts the file into line batches,
+// parser threads turn each batch into students and sort it into a run, and
+// the calling thread appends batches in file order while extending the
+// search indexes. When the file is exhausted the runs are k-way merged into
+// each manager's sorted view, so the data is loaded, indexed and sorted
+// with one pass over the file. Students, warnings and counts come out
+// exactly as loadStudentsFromStream would produce them.
+class IngestPipeline {
+private:
+    struct LineBatch {
+        size_t seq;
+        int firstLine;
+        std::vector<std::string> lines;
+    };
+
+    struct ParsedBatch {
+        size_t seq;
+        std::vector<IIITStudent> iiit;
+        std::vector<IITStudent> iit;
+        std::vector<int> iiitRun;   // Batch-local order of iiit
+        std::vector<int> iitRun;
+        LoadResult counts;
+        std::string warnings;
+    };
+
+    IngestOptions options;
+
+    static long long nsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    template<typename StudentType>
+    static std::vector<int> sortedRun(const std::vector<StudentType>& batch) {
+        std::vector<int> run(batch.size());
+        for (size_t i = 0; i < run.size(); i++) run[i] = static_cast<int>(i);
+        std::sort(run.begin(), run.end(), [&batch](int a, int b) { return batch[a] < batch[b]; });
+        return run;
+    }
+
+    static ParsedBatch parseBatch(LineBatch& input) {
+        ParsedBatch out;
+        out.seq = input.seq;
+        out.iiit.reserve(input.lines.size());
+        std::ostringstream warn;
+        int lineNumber = input.firstLine;
+        for (const auto& line : input.lines) {
+            RowOutcome outcome = parseStudentRow(line, lineNumber++,
+                [&](IIITStudent&& student) { out.iiit.push_back(std::move(student)); },
+                [&](IITStudent&& student) { out.iit.push_back(std::move(student)); }, warn);
+            if (outcome.accepted) out.counts.successCount++;
+            out.counts.errorCount += outcome.errors;
+        }
+        out.iiitRun = sortedRun(out.iiit);
+        out.iitRun = sortedRun(out.iit);
+        out.warnings = warn.str();
+        return out;
+    }
+
+    // Existing students (if any) become the first run, indexed up front.
+    // The runs merge by operator<, so an order by a custom key (or restored
+    // from a snapshot, key unknown) is re-sorted first
+    template<typename RollType, typename CourseType>
+    static void prepareTarget(StudentManager<RollType, CourseType>& manager, SearchIndex<CourseType>& index,
+                              std::vector<std::vector<int>>& runs) {
+        if (manager.getTotalStudents() == 0) {
+            index.clear();
+            return;
+        }
+        if (index.getIndexedStudentCount() != manager.getTotalStudents() ||
+            index.getCourseVersion() != manager.getCourseVersion()) {
+            index.clear();
+            index.buildIndex(std::as_const(manager).getStudents());
+            index.setCourseVersion(manager.getCourseVersion());
+        }
+        if (!manager.hasDefaultSortedOrder()) manager.sortStudents();
+        runs.push_back(manager.getSortedOrderIndices());
+    }
+
+    template<typename RollType, typename CourseType>
+    static void appendBatch(StudentManager<RollType, CourseType>& manager, SearchIndex<CourseType>& index,
+                            std::vector<Student<RollType, CourseType>>& batch, std::vector<int>& run,
+                            std::vector<std::vector<int>>& runs) {
+        if (batch.empty()) return;
+        int base = static_cast<int>(manager.getTotalStudents());
+        index.appendBatch(batch, base);
+        for (auto& student : batch) {
+            manager.addStudent(std::move(student));
+        }
+        for (int& idx : run) idx += base;
+        runs.push_back(std::move(run));
+    }
+
+    // Heap merge of the sorted runs into the manager's sorted view
+    template<typename RollType, typename CourseType>
+    static void mergeRuns(StudentManager<RollType, CourseType>& manager, std::vector<std::vector<int>>& runs) {
+        ScopedTimer span("ingest.merge_runs", "ingest");
+        span.arg("runs", (long long)runs.size());
+        const auto& students = std::as_const(manager).getStudents();
+        if (students.empty()) return;
+
+        // (run, position); the heap top is the smallest student, ties by storage index
+        auto after = [&](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+            int ia = runs[a.first][a.second], ib = runs[b.first][b.second];
+            if (students[ib] < students[ia]) return true;
+            if (students[ia] < students[ib]) return false;
+            return ia > ib;
+        };
+        std::priority_queue<std::pair<size_t, size_t>, std::vector<std::pair<size_t, size_t>>,
+                            decltype(after)> heap(after);
+        for (size_t r = 0; r < runs.size(); r++) {
+            if (!runs[r].empty()) heap.push({r, 0});
+        }
+
+        std::vector<int> merged;
+        merged.reserve(students.size());
+        while (!heap.empty()) {
+            auto top = heap.top();
+            heap.pop();
+            merged.push_back(runs[top.first][top.second]);
+            if (++top.second < runs[top.first].size()) heap.push(top);
+        }
+        runs.clear();
+        manager.restoreSortedOrder(std::move(merged), std::less<Student<RollType, CourseType>>());
+    }
+
+public:
+    explicit IngestPipeline(const IngestOptions& opts = IngestOptions()) : options(opts) {
+        if (options.parserThreads <= 0) {
+            options.parserThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (options.batchRows == 0) options.batchRows = 1;
+        if (options.queueDepth == 0) options.queueDepth = 2 * options.parserThreads;
+    }
+
+    /**
+     * Ingest CSV text (header + rows) into both managers and their indexes
+     * Throws runtime_error if the header cannot be read; a failure in any
+     * stage stops the pipeline and is rethrown here
+     */
+    IngestReport run(std::istream& in, IIITStudentManager& iiitManager, SearchIndex<IIITCourse>& iiitIndex,
+                     IITStudentManager& iitManager, SearchIndex<IITCourse>& iitIndex) {
+        ScopedTimer span("ingest", "ingest");
+        auto start = std::chrono::steady_clock::now();
+        IngestReport report;
+        report.parserThreads = options.parserThreads;
+
+        std::string header;
+        if (!std::getline(in, header)) {
+            throw std::runtime_error("File is empty or cannot be read");
+        }
+
+        std::vector<std::vector<int>> iiitRuns, iitRuns;
+        prepareTarget(iiitManager, iiitIndex, iiitRuns);
+        prepareTarget(iitManager, iitIndex, iitRuns);
+
+        BoundedQueue<LineBatch> lineQueue(options.queueDepth);
+        BoundedQueue<ParsedBatch> parsedQueue(options.queueDepth);
+        // One credit per batch read but not yet assembled. The reader waits
+        // for a free credit, so parsers can only run a bounded distance
+        // ahead of a slow batch and the reorder buffer stays bounded too
+        BoundedQueue<size_t> inFlight(2 * options.queueDepth + options.parserThreads);
+        std::atomic<long long> parseNs(0);
+        std::atomic<int> parsersLeft(options.parserThreads);
+        std::mutex failureLock;
+        std::exception_ptr failure;
+        auto fail = [&](std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> guard(failureLock);
+                if (!failure) failure = error;
+            }
+            lineQueue.close();
+            parsedQueue.close();
+            inFlight.close();
+        };
+
+        std::thread reader([&] {
+            try {
+                Metrics::instance().setThreadName("ingest-reader");
+                size_t seq = 0;
+                int lineNumber = 2;
+                while (true) {
+                    auto readStart = std::chrono::steady_clock::now();
+                    LineBatch batch{seq++, lineNumber, {}};
+                    batch.lines.reserve(options.batchRows);
+                    std::string line;
+                    while (batch.lines.size() < options.batchRows && std::getline(in, line)) {
+                        batch.lines.push_back(std::move(line));
+                    }
+                    report.readNs += nsSince(readStart);
+                    if (batch.lines.empty()) break;
+                    lineNumber += static_cast<int>(batch.lines.size());
+                    if (!inFlight.push(batch.seq)) break;
+                    if (!lineQueue.push(std::move(batch))) break;
+                }
+                lineQueue.close();
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        });
+
+        std::vector<std::thread> parsers;
+        for (int p = 0; p < options.parserThreads; p++) {
+            parsers.emplace_back([&, p] {
+                try {
+                    Metrics::instance().setThreadName("ingest-parser-" + std::to_string(p));
+                    LineBatch batch;
+                    while (lineQueue.pop(batch)) {
+                        ScopedTimer batchSpan("ingest.parse_batch", "ingest");
+                        batchSpan.arg("seq", (long long)batch.seq);
+                        auto parseStart = std::chrono::steady_clock::now();
+                        ParsedBatch parsed = parseBatch(batch);
+                        parseNs += nsSince(parseStart);
+                        if (!parsedQueue.push(std::move(parsed))) break;
+                    }
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+                if (--parsersLeft == 0) parsedQueue.close();
+            });
+        }
+
+        // Assemble on this thread, strictly in file order
+        try {
+            std::map<size_t, ParsedBatch> waiting;
+            size_t nextSeq = 0;
+            ParsedBatch parsed;
+            while (parsedQueue.pop(parsed)) {
+                waiting.emplace(parsed.seq, std::move(parsed));
+                for (auto it = waiting.find(nextSeq); it != waiting.end(); it = waiting.find(++nextSeq)) {
+                    ScopedTimer batchSpan("ingest.assemble_batch", "ingest");
+                    auto assembleStart = std::chrono::steady_clock::now();
+                    ParsedBatch& batch = it->second;
+                    std::cerr << batch.warnings;
+                    report.load.successCount += batch.counts.successCount;
+                    report.load.errorCount += batch.counts.errorCount;
+                    appendBatch(iiitManager, iiitIndex, batch.iiit, batch.iiitRun, iiitRuns);
+                    appendBatch(iitManager, iitIndex, batch.iit, batch.iitRun, iitRuns);
+                    waiting.erase(it);
+                    size_t credit;
+                    inFlight.pop(credit);
+                    report.batches++;
+                    report.assembleNs += nsSince(assembleStart);
+                }
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+
+        reader.join();
+        for (auto& t : parsers) t.join();
+        if (failure) std::rethrow_exception(failure);
+
+        // Merge both systems' runs concurrently
+        auto mergeStart = std::chrono::steady_clock::now();
+        report.iiitRuns = iiitRuns.size();
+        report.iitRuns = iitRuns.size();
+        std::exception_ptr iitFailure;
+        std::thread iitMerge([&] {
+            try {
+                mergeRuns(iitManager, iitRuns);
+            } catch (...) {
+                iitFailure = std::current_exception();
+            }
+        });
+        try {
+            mergeRuns(iiitManager, iiitRuns);
+        } catch (...) {
+            iitMerge.join();
+            throw;
+        }
+        iitMerge.join();
+        if (iitFailure) std::rethrow_exception(iitFailure);
+        report.mergeNs = nsSince(mergeStart);
+
+        report.parseNs = parseNs.load();
+        report.totalNs = nsSince(start);
+        span.arg("rows", report.load.successCount);
+        return report;
+    }
+};
+
+/**
+ * Ingest a CSV file; throws runtime_error if it cannot be opened or read
+ */
+inline IngestReport ingestStudentsFromFile(const std::string& filename, const IngestOptions& options,
+                                           IIITStudentManager& iiitManager, SearchIndex<IIITCourse>& iiitIndex,
+                                           IITStudentManager& iitManager, SearchIndex<IITCourse>& iitIndex) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    return IngestPipeline(options).run(file, iiitManager, iiitIndex, iitManager, iitIndex);
+}
+
+#endif // INGEST_PIPELINE_H
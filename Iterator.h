@@ -4,129 +4,194 @@
 #include <vector>
 #include <cstddef>
 #include <iterator>
+#include <type_traits>
 
-// Iterator for records in order of entry (insertion order)
+// Random-access iterator over records visited through an index order:
+// element i is (*data)[(*indices)[i]]. T may be const-qualified for a
+// read-only view; a mutable iterator converts to the const one, and the
+// two compare and subtract with each other.
 template<typename T>
-class InsertionOrderIterator {
-private:
-    std::vector<T>* data;
-    std::vector<int>* indices;
-    size_t currentIndex;
-
+class IndexOrderIterator {
 public:
-    InsertionOrderIterator(std::vector<T>* d, std::vector<int>* idx)
-        : data(d), indices(idx), currentIndex(0) {}
-
     using difference_type = std::ptrdiff_t;
-    using value_type = T;
+    using value_type = typename std::remove_const<T>::type;
     using pointer = T*;
     using reference = T&;
-    using iterator_category = std::forward_iterator_tag;
-
-    InsertionOrderIterator& operator++() {
-        ++currentIndex;
-        return *this;
-    }
-
-    T& operator*() {
-        return (*data)[(*indices)[currentIndex]];
-    }
-
-    T* operator->() {
-        return &(*data)[(*indices)[currentIndex]];
-    }
-
-    bool operator==(const InsertionOrderIterator& other) const {
-        return currentIndex == other.currentIndex;
-    }
-
-    bool operator!=(const InsertionOrderIterator& other) const {
-        return !(*this == other);
-    }
+    using iterator_category = std::random_access_iterator_tag;
 
-    size_t getSize() const { return indices->size(); }
-};
+    // std::vector<Record> or const std::vector<Record>, following T
+    using Container = typename std::conditional<std::is_const<T>::value,
+        const std::vector<value_type>, std::vector<value_type>>::type;
 
-// Iterator for sorted order records
-template<typename T>
-class SortedOrderIterator {
 private:
-    std::vector<T>* data;
-    std::vector<int>* indices;
-    size_t currentIndex;
+    Container* data;
+    const std::vector<int>* indices;
+    difference_type currentIndex;
+
+    template<typename U> friend class IndexOrderIterator;
 
 public:
-    SortedOrderIterator(std::vector<T>* d, std::vector<int>* idx)
+    IndexOrderIterator() : data(nullptr), indices(nullptr), currentIndex(0) {}
+
+    IndexOrderIterator(Container* d, const std::vector<int>* idx)
         : data(d), indices(idx), currentIndex(0) {}
 
-    using difference_type = std::ptrdiff_t;
-    using value_type = T;
-    using pointer = T*;
-    using reference = T&;
-    using iterator_category = std::random_access_iterator_tag;
+    // Start at position start of the index order (e.g. the end of a range)
+    IndexOrderIterator(Container* d, const std::vector<int>* idx, size_t start)
+        : data(d), indices(idx), currentIndex(static_cast<difference_type>(start)) {}
+
+    // Mutable -> const conversion
+    template<typename U, typename = typename std::enable_if<
+        std::is_same<const U, T>::value && !std::is_const<U>::value>::type>
+    IndexOrderIterator(const IndexOrderIterator<U>& other)
+        : data(other.data), indices(other.indices), currentIndex(other.currentIndex) {}
 
-    SortedOrderIterator& operator++() {
+    IndexOrderIterator& operator++() {
         ++currentIndex;
         return *this;
     }
 
-    SortedOrderIterator operator++(int) {
-        SortedOrderIterator tmp = *this;
+    IndexOrderIterator operator++(int) {
+        IndexOrderIterator tmp = *this;
         ++currentIndex;
         return tmp;
     }
 
-    SortedOrderIterator& operator--() {
+    IndexOrderIterator& operator--() {
         --currentIndex;
         return *this;
     }
 
-    SortedOrderIterator operator--(int) {
-        SortedOrderIterator tmp = *this;
+    IndexOrderIterator operator--(int) {
+        IndexOrderIterator tmp = *this;
         --currentIndex;
         return tmp;
     }
 
-    SortedOrderIterator operator+(difference_type n) const {
-        SortedOrderIterator tmp = *this;
-        tmp.currentIndex += n;
-        return tmp;
+    IndexOrderIterator& operator+=(difference_type n) {
+        currentIndex += n;
+        return *this;
     }
 
-    SortedOrderIterator& operator+=(difference_type n) {
-        currentIndex += n;
+    IndexOrderIterator& operator-=(difference_type n) {
+        currentIndex -= n;
         return *this;
     }
 
-    T& operator*() {
-        return (*data)[(*indices)[currentIndex]];
+    IndexOrderIterator operator+(difference_type n) const {
+        IndexOrderIterator tmp = *this;
+        tmp.currentIndex += n;
+        return tmp;
     }
 
-    T* operator->() {
-        return &(*data)[(*indices)[currentIndex]];
+    friend IndexOrderIterator operator+(difference_type n, const IndexOrderIterator& it) {
+        return it + n;
     }
 
-    bool operator==(const SortedOrderIterator& other) const {
-        return currentIndex == other.currentIndex;
+    IndexOrderIterator operator-(difference_type n) const {
+        IndexOrderIterator tmp = *this;
+        tmp.currentIndex -= n;
+        return tmp;
     }
 
-    bool operator!=(const SortedOrderIterator& other) const {
-        return !(*this == other);
+    reference operator*() const {
+        return (*data)[(*indices)[currentIndex]];
     }
 
-    bool operator<(const SortedOrderIterator& other) const {
-        return currentIndex < other.currentIndex;
+    pointer operator->() const {
+        return &(*data)[(*indices)[currentIndex]];
     }
 
-    difference_type operator-(const SortedOrderIterator& other) const {
-        return currentIndex - other.currentIndex;
+    // Element n positions from this one
+    reference operator[](difference_type n) const {
+        return (*data)[(*indices)[currentIndex + n]];
     }
 
+    // Position in the index order
+    difference_type position() const { return currentIndex; }
+
+    // Length of the whole index order
     size_t getSize() const { return indices->size(); }
 
-    T& operator[](size_t idx) {
-        return (*data)[(*indices)[idx]];
-    }
+    // Storage index of the current element
+    int storageIndex() const { return (*indices)[currentIndex]; }
+};
+
+// Distance and comparisons between iterators of one order; either side may
+// be the mutable or the const iterator
+template<typename A, typename B>
+using SameIndexOrderRecord = typename std::enable_if<
+    std::is_same<typename std::remove_const<A>::type, typename std::remove_const<B>::type>::value>::type;
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+std::ptrdiff_t operator-(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) {
+    return a.position() - b.position();
+}
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+bool operator==(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) { return a.position() == b.position(); }
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+bool operator!=(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) { return a.position() != b.position(); }
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+bool operator<(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) { return a.position() < b.position(); }
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+bool operator>(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) { return a.position() > b.position(); }
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+bool operator<=(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) { return a.position() <= b.position(); }
+
+template<typename A, typename B, typename = SameIndexOrderRecord<A, B>>
+bool operator>=(const IndexOrderIterator<A>& a, const IndexOrderIterator<B>& b) { return a.position() >= b.position(); }
+
+// Iterator for records in order of entry (insertion order)
+template<typename T>
+using InsertionOrderIterator = IndexOrderIterator<T>;
+
+// Iterator for sorted order records
+template<typename T>
+using SortedOrderIterator = IndexOrderIterator<T>;
+
+// Positions [first, last) of an index order, usable in range-based for
+// loops and with std algorithms via begin()/end()
+template<typename T>
+class IndexOrderRange {
+public:
+    using iterator = IndexOrderIterator<T>;
+    using Container = typename iterator::Container;
+
+private:
+    Container* data;
+    const std::vector<int>* indices;
+    size_t first;
+    size_t last;
+
+public:
+    IndexOrderRange(Container* d, const std::vector<int>* idx, size_t from, size_t to)
+        : data(d), indices(idx), first(from), last(to) {}
+
+    // The whole index order
+    IndexOrderRange(Container* d, const std::vector<int>* idx)
+        : data(d), indices(idx), first(0), last(idx->size()) {}
+
+    iterator begin() const { return iterator(data, indices, first); }
+    iterator end() const { return iterator(data, indices, last); }
+
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+
+    T& operator[](size_t i) const { return (*data)[(*indices)[first + i]]; }
+
+    // Storage index of the i-th element of the range
+    int storageIndex(size_t i) const { return (*indices)[first + i]; }
 };
 
+template<typename T>
+using InsertionOrderRange = IndexOrderRange<T>;
+
+template<typename T>
+using SortedOrderRange = IndexOrderRange<T>;
+
 #endif // ITERATOR_H
@@ -0,0 +1,324 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Lightweight instrumentation: scoped timers, counters and free-form log
+// text. Recording threads only append to their own buffer (an uncontended
+// per-thread lock); a background flusher collects the buffers and writes
+// JSON-lines metrics and/or a Chrome trace_event file (open it in
+// Perfetto / chrome://tracing to see which thread did what). Nothing is
+// formatted or written on the recording thread.
+class Metrics {
+public:
+    struct Event {
+        char phase;            // 'X' = span, 'C' = counter, 'M' = thread name
+        std::string name;
+        const char* category;
+        long long tsNs;        // Since process start
+        long long durNs;
+        int tid;
+        std::string args;      // JSON object members, without braces
+    };
+
+private:
+    struct ThreadBuffer {
+        std::mutex lock;
+        std::vector<Event> events;
+        int tid;
+    };
+
+    // Owns the calling thread's buffer; hands leftovers back on thread exit
+    struct ThreadHandle {
+        ThreadBuffer* buffer = nullptr;
+        ~ThreadHandle() {
+            if (buffer) Metrics::instance().retireBuffer(buffer);
+        }
+    };
+
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<bool> enabledFlag;
+    std::atomic<int> nextTid;
+
+    std::mutex registryMutex;              // Guards everything below
+    std::vector<ThreadBuffer*> buffers;
+    std::vector<Event> retired;            // Events of threads that already exited
+    std::vector<std::pair<std::string, std::string>> pendingText; // (path, text)
+    std::thread flusher;
+    std::condition_variable wake;
+    bool stopping;
+
+    std::ofstream jsonlFile;               // Only touched by the flusher / close()
+    std::ofstream traceFile;
+    bool traceHasEvents;
+
+    Metrics() : epoch(std::chrono::steady_clock::now()), enabledFlag(false), nextTid(1),
+                stopping(false), traceHasEvents(false) {}
+
+    ~Metrics() {
+        close();
+    }
+
+    ThreadBuffer& localBuffer() {
+        thread_local ThreadHandle handle;
+        if (!handle.buffer) {
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->tid = nextTid.fetch_add(1);
+            std::lock_guard<std::mutex> guard(registryMutex);
+            buffers.push_back(buffer);
+            handle.buffer = buffer;
+        }
+        return *handle.buffer;
+    }
+
+    void retireBuffer(ThreadBuffer* buffer) {
+        std::lock_guard<std::mutex> guard(registryMutex);
+        for (auto& event : buffer->events) {
+            retired.push_back(std::move(event));
+        }
+        for (size_t i = 0; i < buffers.size(); i++) {
+            if (buffers[i] == buffer) {
+                buffers.erase(buffers.begin() + i);
+                break;
+            }
+        }
+        delete buffer;
+    }
+
+    void push(Event event) {
+        ThreadBuffer& buffer = localBuffer();
+        event.tid = buffer.tid;
+        std::lock_guard<std::mutex> guard(buffer.lock);
+        buffer.events.push_back(std::move(event));
+    }
+
+    // Must hold registryMutex
+    void startFlusherLocked() {
+        if (flusher.joinable() || stopping) return;
+        flusher = std::thread([this] { flushLoop(); });
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> guard(registryMutex);
+        while (!stopping) {
+            wake.wait_for(guard, std::chrono::milliseconds(100));
+            drainLocked(guard);
+        }
+    }
+
+    // Swap out all pending events/text, then write them with the registry unlocked
+    void drainLocked(std::unique_lock<std::mutex>& guard) {
+        std::vector<Event> events;
+        events.swap(retired);
+        for (ThreadBuffer* buffer : buffers) {
+            std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+            for (auto& event : buffer->events) {
+                events.push_back(std::move(event));
+            }
+            buffer->events.clear();
+        }
+        std::vector<std::pair<std::string, std::string>> text;
+        text.swap(pendingText);
+
+        guard.unlock();
+        writeEvents(events);
+        for (const auto& entry : text) {
+            std::ofstream logFile(entry.first, std::ios::app);
+            logFile << entry.second;
+        }
+        guard.lock();
+    }
+
+    static std::string quote(const std::string& value) {
+        std::string out = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out.push_back(c);
+            }
+        }
+        out.push_back('"');
+        return out;
+    }
+
+    void writeEvents(const std::vector<Event>& events) {
+        for (const Event& e : events) {
+            char times[96];
+            if (jsonlFile.is_open() && e.phase != 'M') {
+                std::snprintf(times, sizeof(times), "\"ts_us\":%.3f,\"dur_us\":%.3f", e.tsNs / 1e3, e.durNs / 1e3);
+                jsonlFile << "{\"type\":\"" << (e.phase == 'X' ? "span" : "counter") << "\",\"name\":"
+                          << quote(e.name) << ",\"cat\":\"" << e.category << "\"," << times
+                          << ",\"tid\":" << e.tid << ",\"args\":{" << e.args << "}}\n";
+            }
+            if (traceFile.is_open()) {
+                std::snprintf(times, sizeof(times), "\"ts\":%.3f", e.tsNs / 1e3);
+                traceFile << (traceHasEvents ? ",\n" : "") << "{\"name\":" << quote(e.name)
+                          << ",\"cat\":\"" << e.category << "\",\"ph\":\"" << e.phase << "\"," << times;
+                if (e.phase == 'X') {
+                    std::snprintf(times, sizeof(times), ",\"dur\":%.3f", e.durNs / 1e3);
+                    traceFile << times;
+                }
+                traceFile << ",\"pid\":1,\"tid\":" << e.tid << ",\"args\":{" << e.args << "}}";
+                traceHasEvents = true;
+            }
+        }
+        if (jsonlFile.is_open()) jsonlFile.flush();
+        if (traceFile.is_open()) traceFile.flush();
+    }
+
+public:
+    static Metrics& instance() {
+        static Metrics metrics;
+        return metrics;
+    }
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    // Start recording; either path may be empty. Throws runtime_error if a file cannot be created
+    void open(const std::string& jsonlPath, const std::string& tracePath) {
+        std::lock_guard<std::mutex> guard(registryMutex);
+        if (!jsonlPath.empty()) {
+            jsonlFile.open(jsonlPath, std::ios::trunc);
+            if (!jsonlFile.is_open()) throw std::runtime_error("Could not create metrics file: " + jsonlPath);
+        }
+        if (!tracePath.empty()) {
+            traceFile.open(tracePath, std::ios::trunc);
+            if (!traceFile.is_open()) throw std::runtime_error("Could not create trace file: " + tracePath);
+            traceFile << "[\n";
+            traceHasEvents = false;
+        }
+        enabledFlag.store(jsonlFile.is_open() || traceFile.is_open(), std::memory_order_release);
+        startFlusherLocked();
+    }
+
+    // Stop the flusher, write everything still buffered and close the files
+    void close() {
+        enabledFlag.store(false, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> guard(registryMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (flusher.joinable()) flusher.join();
+
+        std::unique_lock<std::mutex> guard(registryMutex);
+        drainLocked(guard);
+        if (traceFile.is_open()) {
+            traceFile << "\n]\n";
+            traceFile.close();
+        }
+        if (jsonlFile.is_open()) jsonlFile.close();
+    }
+
+    bool enabled() const {
+        return enabledFlag.load(std::memory_order_relaxed);
+    }
+
+    long long nowNs() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void recordSpan(std::string name, const char* category, long long startNs, long long durNs,
+                    std::string args = "") {
+        if (!enabled()) return;
+        push(Event{'X', std::move(name), category, startNs, durNs, 0, std::move(args)});
+    }
+
+    void recordCounter(std::string name, const char* category, double value) {
+        if (!enabled()) return;
+        char args[48];
+        std::snprintf(args, sizeof(args), "\"value\":%.6g", value);
+        push(Event{'C', std::move(name), category, nowNs(), 0, 0, args});
+    }
+
+    // Label the calling thread in the trace (e.g. "sort-worker-3")
+    void setThreadName(const std::string& name) {
+        if (!enabled()) return;
+        push(Event{'M', "thread_name", "meta", 0, 0, 0, "\"name\":" + quote(name)});
+    }
+
+    // Append text to a plain log file from the background flusher
+    void appendText(const std::string& path, std::string text) {
+        {
+            std::lock_guard<std::mutex> guard(registryMutex);
+            pendingText.emplace_back(path, std::move(text));
+            if (stopping) {
+                // Late message after close(): write it directly
+                std::ofstream logFile(path, std::ios::app);
+                logFile << pendingText.back().second;
+                pendingText.pop_back();
+                return;
+            }
+            startFlusherLocked();
+        }
+        wake.notify_one();
+    }
+};
+
+// Records a span from construction to destruction when metrics are enabled;
+// costs one relaxed atomic load otherwise
+class ScopedTimer {
+private:
+    const char* name;
+    const char* category;
+    long long startNs;
+    bool active;
+    std::string args;
+
+public:
+    ScopedTimer(const char* n, const char* cat)
+        : name(n), category(cat), startNs(0), active(Metrics::instance().enabled()) {
+        if (active) startNs = Metrics::instance().nowNs();
+    }
+
+    ~ScopedTimer() {
+        if (active) {
+            Metrics& metrics = Metrics::instance();
+            metrics.recordSpan(name, category, startNs, metrics.nowNs() - startNs, std::move(args));
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void arg(const char* key, long long value) {
+        if (!active) return;
+        if (!args.empty()) args.push_back(',');
+        args += "\"";
+        args += key;
+        args += "\":" + std::to_string(value);
+    }
+
+    void arg(const char* key, const std::string& value) {
+        if (!active) return;
+        if (!args.empty()) args.push_back(',');
+        args += "\"";
+        args += key;
+        args += "\":\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') args.push_back('\\');
+            if (static_cast<unsigned char>(c) >= 0x20) args.push_back(c);
+        }
+        args += "\"";
+    }
+};
+
+#endif // METRICS_H
@@ -0,0 +1,130 @@
+#ifndef PACKED_ROLL_H
+#define PACKED_ROLL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+// Roll number key with the first 16 characters packed into two 64-bit
+// words, first character in the most significant byte and zero padding
+// after the last. Comparing the words as integers gives the same order as
+// comparing the roll strings, so lookups, duplicate checks and roll sorts
+// of typical rolls never touch string code. Any roll is accepted: one
+// longer than 16 characters (or containing '\0') also points at its full
+// text, interned for the life of the process, which breaks ties between
+// equal packed prefixes. Used as the IIIT RollType.
+class PackedRoll {
+public:
+    static constexpr size_t MAX_LENGTH = 16;  // Characters held inline
+
+private:
+    uint64_t high;                 // Characters 0-7
+    uint64_t low;                  // Characters 8-15
+    const std::string* overflow;   // Whole roll if it does not fit inline, else nullptr
+
+    constexpr char charAt(size_t i) const {
+        uint64_t word = i < 8 ? high : low;
+        return static_cast<char>((word >> (8 * (7 - i % 8))) & 0xFF);
+    }
+
+    // One shared copy per distinct long roll, so equal rolls share a pointer
+    static const std::string* intern(std::string_view text) {
+        static std::mutex poolMutex;
+        static std::unordered_set<std::string> pool;  // Node-based: pointers stay valid
+        std::lock_guard<std::mutex> lock(poolMutex);
+        return &*pool.emplace(text).first;
+    }
+
+public:
+    constexpr PackedRoll() : high(0), low(0), overflow(nullptr) {}
+
+    explicit PackedRoll(std::string_view text) : high(0), low(0), overflow(nullptr) {
+        uint64_t words[2] = {0, 0};
+        bool inlineOnly = text.size() <= MAX_LENGTH;
+        for (size_t i = 0; i < text.size() && i < MAX_LENGTH; i++) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c == 0) inlineOnly = false;
+            words[i / 8] |= uint64_t(c) << (8 * (7 - i % 8));
+        }
+        high = words[0];
+        low = words[1];
+        if (!inlineOnly) overflow = intern(text);
+    }
+
+    // True if the roll is held entirely in the two words
+    constexpr bool isInline() const { return overflow == nullptr; }
+
+    size_t size() const {
+        if (overflow) return overflow->size();
+        size_t length = 0;
+        while (length < MAX_LENGTH && charAt(length) != '\0') length++;
+        return length;
+    }
+
+    constexpr bool empty() const { return high == 0 && overflow == nullptr; }
+
+    // Roll text; inline rolls are unpacked into buffer
+    std::string_view view(char (&buffer)[MAX_LENGTH]) const {
+        if (overflow) return *overflow;
+        size_t length = 0;
+        while (length < MAX_LENGTH && (buffer[length] = charAt(length)) != '\0') length++;
+        return std::string_view(buffer, length);
+    }
+
+    std::string str() const {
+        char buffer[MAX_LENGTH];
+        return std::string(view(buffer));
+    }
+
+    // std::string::compare(pos, count, other) on the unpacked roll
+    int compare(size_t pos, size_t count, const std::string& other) const {
+        char buffer[MAX_LENGTH];
+        return view(buffer).compare(pos, count, other);
+    }
+
+    bool operator==(const PackedRoll& other) const {
+        return high == other.high && low == other.low && overflow == other.overflow;
+    }
+    bool operator!=(const PackedRoll& other) const { return !(*this == other); }
+
+    // Equal words mean equal first 16 characters; an inline roll is then a
+    // prefix of (so less than) a long one, and two long rolls compare as text
+    bool operator<(const PackedRoll& other) const {
+        if (high != other.high) return high < other.high;
+        if (low != other.low) return low < other.low;
+        if (overflow == other.overflow) return false;
+        if (!overflow || !other.overflow) return !overflow;
+        return *overflow < *other.overflow;
+    }
+    bool operator>(const PackedRoll& other) const { return other < *this; }
+    bool operator<=(const PackedRoll& other) const { return !(other < *this); }
+    bool operator>=(const PackedRoll& other) const { return !(*this < other); }
+
+    size_t hash() const {
+        uint64_t h = high * 0x9E3779B97F4A7C15ULL ^ low ^ reinterpret_cast<uintptr_t>(overflow);
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ULL;
+        h ^= h >> 32;
+        return static_cast<size_t>(h);
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const PackedRoll& roll) {
+        char buffer[MAX_LENGTH];
+        std::string_view text = roll.view(buffer);
+        return out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+};
+
+namespace std {
+template<>
+struct hash<PackedRoll> {
+    size_t operator()(const PackedRoll& roll) const noexcept { return roll.hash(); }
+};
+}
+
+#endif // PACKED_ROLL_H
@@ -0,0 +1,427 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <condition_variable>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Line-oriented request server on a Unix domain socket or localhost TCP.
+// One epoll thread accepts connections and reads request lines; a fixed
+// pool of workers runs the handler and writes one response line per
+// request. A connection is served by at most one worker at a time, so
+// pipelined requests are answered in the order they were sent. A
+// connection whose queue fills up stops being read until a worker has
+// answered half of it, so a client that never reads replies cannot grow
+// the queue without bound.
+class QueryServer {
+public:
+    // Maps one request line (without newline) to one response line
+    using Handler = std::function<std::string(const std::string& request)>;
+
+    static constexpr size_t MAX_REQUEST_BYTES = 64 * 1024;
+    static constexpr size_t MAX_QUEUED_REQUESTS = 128;  // Per connection
+
+private:
+    struct Connection {
+        int fd;
+        std::string input;                 // Bytes read but not yet split into lines (epoll thread only)
+        std::mutex lock;                   // Guards everything below
+        std::deque<std::string> requests;  // Complete lines waiting for a worker
+        bool busy = false;                 // A worker currently owns this connection
+        bool closed = false;               // Peer gone or QUIT received
+        bool paused = false;               // Queue full: socket removed from EPOLLIN
+        std::string closeWith;             // Final response after the queued requests, then close
+
+        explicit Connection(int socketFd) : fd(socketFd) {}
+        ~Connection() { ::close(fd); }
+    };
+
+    Handler handler;
+    int numWorkers;
+    int listenFd;
+    int epollFd;
+    int wakeFd;                            // eventfd written by stop()
+    std::string unixPath;                  // Unlinked on shutdown
+    std::map<int, std::shared_ptr<Connection>> connections; // epoll thread only
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::shared_ptr<Connection>> readyQueue;
+    bool shuttingDown;
+
+    std::atomic<unsigned long long> requestsServed;
+    std::atomic<unsigned long long> connectionsAccepted;
+
+    static void setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    void addToEpoll(int fd) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            throw std::runtime_error(std::string("epoll_ctl failed: ") + std::strerror(errno));
+        }
+    }
+
+    // Stop or resume reading a connection; call with conn->lock held. Only
+    // EPOLLHUP/EPOLLERR are reported while paused. Fails harmlessly (ENOENT)
+    // if the epoll thread has just dropped the connection
+    void setReading(Connection& conn, bool reading) {
+        if (conn.closed || conn.paused == !reading) return;
+        epoll_event ev{};
+        ev.events = reading ? (EPOLLIN | EPOLLRDHUP) : 0;
+        ev.data.fd = conn.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &ev);
+        conn.paused = !reading;
+    }
+
+    // Move the complete lines of input into lines, keeping the partial rest
+    static void splitLines(std::string& input, std::vector<std::string>& lines) {
+        size_t start = 0, newline;
+        while ((newline = input.find('\n', start)) != std::string::npos) {
+            size_t end = newline;
+            if (end > start && input[end - 1] == '\r') end--;
+            lines.push_back(input.substr(start, end - start));
+            start = newline + 1;
+        }
+        input.erase(0, start);
+    }
+
+    void bindAndListen(int fd, const sockaddr* addr, socklen_t len, const std::string& where) {
+        if (fd < 0) {
+            throw std::runtime_error(std::string("Could not create socket: ") + std::strerror(errno));
+        }
+        if (::bind(fd, addr, len) != 0 || ::listen(fd, 128) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Could not listen on " + where + ": " + std::strerror(err));
+        }
+        setNonBlocking(fd);
+        listenFd = fd;
+    }
+
+    // Write a whole response, waiting for the socket when its buffer is full
+    static bool sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                pollfd p{fd, POLLOUT, 0};
+                if (::poll(&p, 1, 5000) <= 0) return false;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void schedule(const std::shared_ptr<Connection>& conn) {
+        {
+            std::lock_guard<std::mutex> guard(queueMutex);
+            readyQueue.push_back(conn);
+        }
+        queueReady.notify_one();
+    }
+
+    void acceptConnections() {
+        while (true) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN: nothing more pending
+            connections[fd] = std::make_shared<Connection>(fd);
+            connectionsAccepted++;
+            addToEpoll(fd);
+        }
+    }
+
+    void dropConnection(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        {
+            std::lock_guard<std::mutex> guard(it->second->lock);
+            it->second->closed = true;
+        }
+        connections.erase(it); // A worker still holding it keeps the fd open
+    }
+
+    // Read what is available (up to a queue's worth of lines) and hand
+    // complete lines to the workers
+    void readRequests(int fd, uint32_t events) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        std::shared_ptr<Connection> conn = it->second;
+
+        size_t room;
+        bool paused;
+        {
+            std::lock_guard<std::mutex> guard(conn->lock);
+            room = MAX_QUEUED_REQUESTS - std::min(conn->requests.size(), MAX_QUEUED_REQUESTS);
+            if (room == 0) setReading(*conn, false);
+            paused = conn->paused;
+        }
+        if (paused) {
+            // Only hang-ups arrive while paused
+            if (events & (EPOLLHUP | EPOLLERR)) dropConnection(fd);
+            return;
+        }
+
+        char buf[16384];
+        bool peerClosed = false;
+        bool tooLong = false;
+        std::vector<std::string> lines;
+        while (lines.size() < room) {
+            ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                conn->input.append(buf, n);
+                splitLines(conn->input, lines);
+                if (conn->input.size() > MAX_REQUEST_BYTES) {
+                    // The worker owning the socket writes the error after the
+                    // answers to the complete lines, so nothing interleaves and
+                    // this thread never blocks on a send
+                    tooLong = true;
+                    std::string().swap(conn->input);
+                    break;
+                }
+            } else if (n == 0) {
+                peerClosed = true;
+                break;
+            } else if (errno == EINTR) {
+                continue;
+            } else {
+                peerClosed = (errno != EAGAIN && errno != EWOULDBLOCK);
+                break;
+            }
+        }
+
+        if (!lines.empty() || tooLong) {
+            bool wasIdle;
+            {
+                std::lock_guard<std::mutex> guard(conn->lock);
+                for (auto& line : lines) conn->requests.push_back(std::move(line));
+                if (tooLong) conn->closeWith = "ERR request too long\n";
+                // Unread bytes stay in the socket until the workers catch up
+                if (conn->requests.size() >= MAX_QUEUED_REQUESTS && !peerClosed && !tooLong) {
+                    setReading(*conn, false);
+                }
+                wasIdle = !conn->busy;
+                conn->busy = true;
+            }
+            if (wasIdle) schedule(conn);
+        }
+        // Requests already queued are still answered; the socket closes when the last owner lets go
+        if (peerClosed || tooLong) dropConnection(fd);
+    }
+
+    // Answer a connection's queued requests in order, then release it
+    void serveConnection(const std::shared_ptr<Connection>& conn) {
+        while (true) {
+            std::string request;
+            std::string finalResponse;
+            {
+                std::lock_guard<std::mutex> guard(conn->lock);
+                if (conn->requests.empty() && conn->closeWith.empty()) {
+                    conn->busy = false;
+                    return;
+                }
+                if (conn->requests.empty()) {
+                    finalResponse.swap(conn->closeWith);
+                } else {
+                    request = std::move(conn->requests.front());
+                    conn->requests.pop_front();
+                    if (conn->paused && conn->requests.size() <= MAX_QUEUED_REQUESTS / 2) setReading(*conn, true);
+                }
+            }
+
+            // Still busy, so no other worker writes meanwhile
+            if (!finalResponse.empty()) {
+                sendAll(conn->fd, finalResponse);
+                ::shutdown(conn->fd, SHUT_WR);
+                std::lock_guard<std::mutex> guard(conn->lock);
+                conn->busy = false;
+                return;
+            }
+
+            if (request == "QUIT" || request == "quit") {
+                std::lock_guard<std::mutex> guard(conn->lock);
+                conn->requests.clear();
+                conn->closeWith.clear();
+                conn->closed = true;
+                ::shutdown(conn->fd, SHUT_RDWR);
+                conn->busy = false;
+                return;
+            }
+
+            std::string response;
+            try {
+                response = handler(request);
+            } catch (const std::exception& e) {
+                response = std::string("ERR ") + e.what();
+            }
+            response.push_back('\n');
+            requestsServed++;
+
+            if (!sendAll(conn->fd, response)) {
+                std::lock_guard<std::mutex> guard(conn->lock);
+                conn->requests.clear();
+                conn->closeWith.clear();
+                setReading(*conn, true);
+                conn->busy = false;
+                return;
+            }
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            std::shared_ptr<Connection> conn;
+            {
+                std::unique_lock<std::mutex> guard(queueMutex);
+                queueReady.wait(guard, [this] { return shuttingDown || !readyQueue.empty(); });
+                if (readyQueue.empty()) return;
+                conn = std::move(readyQueue.front());
+                readyQueue.pop_front();
+            }
+            serveConnection(conn);
+        }
+    }
+
+public:
+    QueryServer(Handler requestHandler, int workers)
+        : handler(std::move(requestHandler)), numWorkers(workers < 1 ? 1 : workers),
+          listenFd(-1), epollFd(-1), wakeFd(-1), shuttingDown(false),
+          requestsServed(0), connectionsAccepted(0) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            throw std::runtime_error(std::string("Could not set up epoll: ") + std::strerror(errno));
+        }
+    }
+
+    ~QueryServer() {
+        connections.clear();
+        if (listenFd >= 0) ::close(listenFd);
+        if (!unixPath.empty()) ::unlink(unixPath.c_str());
+        ::close(wakeFd);
+        ::close(epollFd);
+    }
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    // Listen on a Unix domain socket (an existing socket file is replaced)
+    void listenUnix(const std::string& path) {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + path);
+        }
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(path.c_str());
+        bindAndListen(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0),
+                      reinterpret_cast<sockaddr*>(&addr), sizeof(addr), path);
+        unixPath = path;
+    }
+
+    // Listen on 127.0.0.1:port (port 0 picks a free port, see getPort)
+    void listenTcp(int port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        bindAndListen(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr),
+                      "127.0.0.1:" + std::to_string(port));
+    }
+
+    int getPort() const {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        if (listenFd < 0 || getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len) != 0 ||
+            addr.sin_family != AF_INET) {
+            return -1;
+        }
+        return ntohs(addr.sin_port);
+    }
+
+    // Serve until stop() is called; throws runtime_error if not listening
+    void run() {
+        if (listenFd < 0) {
+            throw std::runtime_error("QueryServer::run called before listen");
+        }
+        addToEpoll(listenFd);
+        addToEpoll(wakeFd);
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < numWorkers; i++) {
+            workers.emplace_back(&QueryServer::workerLoop, this);
+        }
+
+        epoll_event events[64];
+        bool running = true;
+        while (running) {
+            int n = epoll_wait(epollFd, events, 64, -1);
+            if (n < 0 && errno != EINTR) break;
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    running = false;
+                } else if (fd == listenFd) {
+                    acceptConnections();
+                } else {
+                    readRequests(fd, events[i].events);
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(queueMutex);
+            shuttingDown = true;
+        }
+        queueReady.notify_all();
+        for (auto& t : workers) {
+            t.join();
+        }
+        readyQueue.clear();
+    }
+
+    // Ask run() to return; async-signal-safe
+    void stop() {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    unsigned long long getRequestsServed() const { return requestsServed.load(); }
+    unsigned long long getConnectionsAccepted() const { return connectionsAccepted.load(); }
+};
+
+#endif // QUERY_SERVER_H
@@ -0,0 +1,253 @@
+#ifndef ROSTER_GENERATOR_H
+#define ROSTER_GENERATOR_H
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <algorithm>
+
+// Settings for synthetic rosters in the students.csv format
+struct RosterConfig {
+    uint64_t seed = 42;
+    double stringRollRatio = 0.45;  // Fraction of MTech-style rolls (MT23xxxx)
+    int minIIITCourses = 1;
+    int maxIIITCourses = 5;
+    int minIITCourses = 0;
+    int maxIITCourses = 3;
+    int iiitCatalogSize = 5;        // Distinct IIIT course codes (max 32)
+    int iitCatalogSize = 5;         // Distinct IIT course codes (max 32)
+    double skew = 0.0;              // Zipf exponent for course/branch/year popularity, 0 = uniform
+    double duplicateRatio = 0.0;    // Fraction of rows reusing an earlier roll number
+    double malformedRatio = 0.0;    // Fraction of rows broken in some way the loader must reject
+};
+
+// Deterministic generator of CSV rows:
+//   RollNumber,Name,Branch,StartYear,IIITCourses(Code:Sem:Grade),IITCourses(Code:Grade)
+// Uses its own splitmix64 stream rather than <random> distributions, so the
+// same seed produces byte-identical output with every compiler/library.
+// Rows are produced one at a time with O(catalog) state, so arbitrarily
+// large rosters can be streamed in constant memory.
+class RosterGenerator {
+public:
+    static constexpr int MAX_CATALOG_SIZE = 32;
+
+private:
+    RosterConfig config;
+    uint64_t state;
+    uint64_t rowIndex;
+    std::vector<double> iiitWeights;   // Cumulative popularity per catalog entry
+    std::vector<double> iitWeights;
+    std::vector<double> branchWeights;
+    std::vector<double> yearWeights;
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t nextRandom() {
+        return mix(state += 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Uniform integer in [0, bound)
+    uint32_t nextBelow(uint32_t bound) {
+        return static_cast<uint32_t>(((nextRandom() >> 32) * bound) >> 32);
+    }
+
+    // Uniform integer in [lo, hi]
+    int nextInRange(int lo, int hi) {
+        if (hi <= lo) return lo;
+        return lo + static_cast<int>(nextBelow(static_cast<uint32_t>(hi - lo + 1)));
+    }
+
+    double nextUnit() {
+        return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Cumulative Zipf weights: entry k has weight 1 / (k + 1)^skew
+    static std::vector<double> zipfCumulative(int size, double skew) {
+        std::vector<double> cumulative(size);
+        double total = 0.0;
+        for (int k = 0; k < size; k++) {
+            total += 1.0 / std::pow(k + 1.0, skew);
+            cumulative[k] = total;
+        }
+        for (double& c : cumulative) c /= total;
+        return cumulative;
+    }
+
+    int nextWeighted(const std::vector<double>& cumulative) {
+        double u = nextUnit();
+        auto it = std::upper_bound(cumulative.begin(), cumulative.end(), u);
+        return it == cumulative.end() ? static_cast<int>(cumulative.size()) - 1
+                                      : static_cast<int>(it - cumulative.begin());
+    }
+
+    static void appendNumber(std::string& out, uint64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        out.append(digits, result.ptr);
+    }
+
+    // The roll of a row is a pure function of (seed, row id), so a duplicate
+    // can re-create any earlier roll without remembering it
+    void appendRoll(std::string& out, uint64_t id) const {
+        uint64_t h = mix(config.seed ^ (id * 0xD6E8FEB86659FD93ULL));
+        double u = (h >> 11) * (1.0 / 9007199254740992.0);
+        if (u < config.stringRollRatio) {
+            out.append("MT2");
+            out.push_back(static_cast<char>('0' + (h & 0xF) % 6));
+            appendNumber(out, id);
+        } else {
+            appendNumber(out, 1000 + id);
+        }
+    }
+
+    static void appendIIITCode(std::string& out, int pick) {
+        static const char* const baseCodes[] = {"DSA", "OS", "OOP", "ML", "DBMS"};
+        if (pick < 5) {
+            out.append(baseCodes[pick]);
+        } else {
+            out.append("CSE");
+            appendNumber(out, 500 + pick);
+        }
+    }
+
+    static int iiitSemester(int pick) {
+        static const int baseSemesters[] = {5, 8, 9, 7, 6};
+        return pick < 5 ? baseSemesters[pick] : 1 + pick % 8;
+    }
+
+    // Append `count` distinct catalog entries drawn by popularity
+    template<typename AppendEntry>
+    void appendDistinct(std::string& out, const std::vector<double>& weights, int count,
+                        AppendEntry appendEntry) {
+        int catalogSize = static_cast<int>(weights.size());
+        uint32_t used = 0;
+        for (int i = 0; i < count; i++) {
+            int pick = nextWeighted(weights);
+            while (used & (1u << pick)) {
+                pick = (pick + 1) % catalogSize;
+            }
+            used |= 1u << pick;
+            if (i > 0) out.push_back(';');
+            appendEntry(pick);
+        }
+    }
+
+    // Replace a well-formed row (without newline) by one of several broken variants
+    void corruptRow(std::string& out, size_t rowStart) {
+        switch (nextBelow(6)) {
+            case 0: // Truncated after the name
+                out.resize(out.find(',', out.find(',', rowStart) + 1));
+                break;
+            case 1: { // Non-numeric year
+                size_t yearStart = rowStart;
+                for (int f = 0; f < 3; f++) yearStart = out.find(',', yearStart) + 1;
+                out.replace(yearStart, 4, "20X1");
+                break;
+            }
+            case 2: { // Year out of range
+                size_t yearStart = rowStart;
+                for (int f = 0; f < 3; f++) yearStart = out.find(',', yearStart) + 1;
+                out.replace(yearStart, 4, "1850");
+                break;
+            }
+            case 3: // Empty roll
+                out.erase(rowStart, out.find(',', rowStart) - rowStart);
+                break;
+            case 4: // Partially numeric roll
+                out.insert(out.find(',', rowStart), "AB");
+                break;
+            default: // Broken course entries
+                out.append(";BAD;X:1:Z");
+                break;
+        }
+    }
+
+public:
+    explicit RosterGenerator(const RosterConfig& cfg = RosterConfig())
+        : config(cfg), state(cfg.seed), rowIndex(0) {
+        config.iiitCatalogSize = std::max(1, std::min(config.iiitCatalogSize, MAX_CATALOG_SIZE));
+        config.iitCatalogSize = std::max(1, std::min(config.iitCatalogSize, MAX_CATALOG_SIZE));
+        config.maxIIITCourses = std::min(config.maxIIITCourses, config.iiitCatalogSize);
+        config.maxIITCourses = std::min(config.maxIITCourses, config.iitCatalogSize);
+        config.minIIITCourses = std::max(0, std::min(config.minIIITCourses, config.maxIIITCourses));
+        config.minIITCourses = std::max(0, std::min(config.minIITCourses, config.maxIITCourses));
+
+        iiitWeights = zipfCumulative(config.iiitCatalogSize, config.skew);
+        iitWeights = zipfCumulative(config.iitCatalogSize, config.skew);
+        branchWeights = zipfCumulative(4, config.skew);
+        yearWeights = zipfCumulative(5, config.skew);
+    }
+
+    static const char* header() {
+        return "RollNumber,Name,Branch,StartYear,IIITCourses(Code:Sem:Grade),IITCourses(Code:Grade)";
+    }
+
+    uint64_t rowsGenerated() const { return rowIndex; }
+
+    // Append the next row, including its trailing newline
+    void appendRow(std::string& out) {
+        static const char* const branches[] = {"CSE", "ECE", "MTech-CSE", "MTech-AI"};
+        static const char* const grades[] = {"A", "A-", "A+", "B+", "B", "C", "D"};
+
+        uint64_t id = rowIndex++;
+        size_t rowStart = out.size();
+
+        // Numeric rolls count up from 1000, string rolls carry the row id
+        // after an MT2<y> prefix; duplicates re-use an earlier row's roll
+        if (id > 0 && config.duplicateRatio > 0 && nextUnit() < config.duplicateRatio) {
+            appendRoll(out, nextRandom() % id);
+        } else {
+            appendRoll(out, id);
+        }
+
+        out.append(",Student_");
+        appendNumber(out, id + 1);
+        out.push_back(',');
+        out.append(branches[nextWeighted(branchWeights)]);
+        out.push_back(',');
+        appendNumber(out, 2024 - nextWeighted(yearWeights));
+        out.push_back(',');
+
+        appendDistinct(out, iiitWeights, nextInRange(config.minIIITCourses, config.maxIIITCourses),
+            [&](int pick) {
+                appendIIITCode(out, pick);
+                out.push_back(':');
+                appendNumber(out, iiitSemester(pick));
+                out.push_back(':');
+                out.append(grades[nextBelow(7)]);
+            });
+        out.push_back(',');
+
+        appendDistinct(out, iitWeights, nextInRange(config.minIITCourses, config.maxIITCourses),
+            [&](int pick) {
+                appendNumber(out, 101 + pick);
+                out.push_back(':');
+                out.append(grades[nextBelow(7)]);
+            });
+
+        if (config.malformedRatio > 0 && nextUnit() < config.malformedRatio) {
+            corruptRow(out, rowStart);
+        }
+        out.push_back('\n');
+    }
+
+    // Whole roster (header + rows) as one string
+    std::string generateCSV(uint64_t rows) {
+        std::string out;
+        out.reserve(rows * 72 + 128);
+        out.append(header());
+        out.push_back('\n');
+        for (uint64_t i = 0; i < rows; i++) {
+            appendRow(out);
+        }
+        return out;
+    }
+};
+
+#endif // ROSTER_GENERATOR_H
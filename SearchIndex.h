@@ -6,6 +6,7 @@
 #include <string>
 #include <set>
 #include <iostream>
+#include "Metrics.h"
 #include "Student.h"  // Include Student.h which now has the course definitions
 
 // Fast search index for students with high grades in specific courses
@@ -14,9 +15,11 @@ class SearchIndex {
 private:
     // Map: CourseCode -> Vector of (StudentIndex, Grade)
     std::map<std::string, std::vector<std::pair<int, int>>> courseGradeIndex;
+    size_t indexedStudents; // Number of students covered by buildIndex
+    unsigned long long courseVersion; // StudentManager::getCourseVersion() the postings reflect
 
 public:
-    SearchIndex() {}
+    SearchIndex() : indexedStudents(0), courseVersion(0) {}
 
     // Add student to index - Generic version
     void addStudent(int studentIndex, const std::string& courseCode, int gradePoints) {
@@ -26,6 +29,7 @@ public:
     // Find all students with grade >= minGrade in specific course
     // Time Complexity: O(k) where k = matching records
     std::vector<int> findStudentsByGradeInCourse(const std::string& courseCode, int minGrade) const {
+        ScopedTimer span("index.lookup_course", "search");
         std::vector<int> results;
         auto it = courseGradeIndex.find(courseCode);
         if (it != courseGradeIndex.end()) {
@@ -41,6 +45,7 @@ public:
     // Find all students with grade >= minGrade across all courses
     // Time Complexity: O(n) where n = total index entries
     std::vector<int> findAllStudentsByGrade(int minGrade) const {
+        ScopedTimer span("index.lookup_all", "search");
         std::vector<int> results;
         std::set<int> uniqueStudents; // To avoid duplicates
         
@@ -62,14 +67,58 @@ public:
     // Build index from students - SPECIALIZED FOR DIFFERENT COURSE TYPES
     template<typename StudentType>
     void buildIndex(const std::vector<StudentType>& students) {
-        for (size_t i = 0; i < students.size(); i++) {
-            const auto& courses = students[i].getCourses();
+        ScopedTimer span("index.build", "index");
+        span.arg("students", (long long)students.size());
+        appendBatch(students, 0);
+    }
+
+    // Index a batch of students whose first element sits at storage index
+    // firstIndex; batches must be appended in storage order
+    template<typename StudentType>
+    void appendBatch(const std::vector<StudentType>& batch, size_t firstIndex) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            const auto& courses = batch[i].getCourses();
             for (const auto& course : courses) {
                 std::string courseCode = getCourseCode(course);
                 int gradePoints = course.getGradePoints();
-                addStudent(static_cast<int>(i), courseCode, gradePoints);
+                addStudent(static_cast<int>(firstIndex + i), courseCode, gradePoints);
             }
         }
+        indexedStudents += batch.size();
+    }
+
+    // Restore all postings of one course at once (e.g. from a snapshot)
+    void addPostings(const std::string& courseCode, std::vector<std::pair<int, int>> postings) {
+        auto& entries = courseGradeIndex[courseCode];
+        if (entries.empty()) {
+            entries = std::move(postings);
+        } else {
+            entries.insert(entries.end(), postings.begin(), postings.end());
+        }
+    }
+
+    void setIndexedStudentCount(size_t count) {
+        indexedStudents = count;
+    }
+
+    // Number of students the index was built over - lets callers detect a stale index
+    size_t getIndexedStudentCount() const {
+        return indexedStudents;
+    }
+
+    // Course version of the manager when the index was built; a different
+    // version means courses were added to indexed students since
+    void setCourseVersion(unsigned long long version) {
+        courseVersion = version;
+    }
+
+    unsigned long long getCourseVersion() const {
+        return courseVersion;
+    }
+
+    // Read-only access to the raw postings (CourseCode -> (StudentIndex, Grade))
+    const std::map<std::string, std::vector<std::pair<int, int>>>& getEntries() const {
+        return courseGradeIndex;
     }
 
     // Get course code from course object - GENERIC VERSION (handles IIITCourse)
@@ -94,6 +143,8 @@ public:
     // Clear the index
     void clear() {
         courseGradeIndex.clear();
+        indexedStudents = 0;
+        courseVersion = 0;
     }
 
     // Get number of indexed courses
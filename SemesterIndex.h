@@ -0,0 +1,191 @@
+#ifndef SEMESTER_INDEX_H
+#define SEMESTER_INDEX_H
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <vector>
+#include "Student.h"
+#include "SmallVector.h"
+#include "Aggregation.h"
+#include "Metrics.h"
+
+// SGPA of one semester and CGPA up to and including it. Every course
+// weighs the same (courses carry no credits), so SGPA is the mean grade
+// points of the semester and CGPA the mean over all courses so far.
+struct SemesterGPA {
+    int semester;
+    int courses;        // Courses taken in this semester
+    int points;         // Sum of their grade points
+    float cgpa;
+
+    double sgpa() const { return courses == 0 ? 0.0 : static_cast<double>(points) / courses; }
+};
+
+// Semesters of one student, ascending; most students fit inline
+using SemesterTimeline = SmallVector<SemesterGPA, 4>;
+
+// SGPA fall between two consecutive semesters of one student
+struct SGPADrop {
+    int student;        // Storage index
+    int fromSemester;
+    int toSemester;
+    double fromSGPA;
+    double toSGPA;
+
+    double drop() const { return fromSGPA - toSGPA; }
+};
+
+// One student's result in a semester ranking
+struct SemesterRank {
+    int student;        // Storage index
+    double sgpa;
+    double cgpa;
+};
+
+// (student, semester) -> SGPA/CGPA for course types with semesters (IIIT).
+// Built once from the students and then kept current by addStudent /
+// addCourse, so warning reports read a few timeline entries per student
+// instead of every course. Students are storage indices, as in SearchIndex.
+template<typename CourseType>
+class SemesterIndex {
+private:
+    using Traits = CourseGroupTraits<CourseType>;
+
+    std::vector<SemesterTimeline> timelines;             // By storage index
+    std::map<int, std::vector<int>> studentsBySemester;  // Students with courses in the semester
+
+    static void updateCGPA(SemesterTimeline& timeline) {
+        long long points = 0, courses = 0;
+        for (SemesterGPA& entry : timeline) {
+            points += entry.points;
+            courses += entry.courses;
+            entry.cgpa = courses == 0 ? 0.0f : static_cast<float>(static_cast<double>(points) / courses);
+        }
+    }
+
+    // Add one course to timeline without refreshing the CGPA column
+    void record(int student, SemesterTimeline& timeline, const CourseType& course) {
+        int semester = Traits::semester(course);
+        auto pos = std::lower_bound(timeline.begin(), timeline.end(), semester,
+            [](const SemesterGPA& entry, int value) { return entry.semester < value; });
+        if (pos == timeline.end() || pos->semester != semester) {
+            size_t at = pos - timeline.begin();
+            timeline.push_back(SemesterGPA{semester, 0, 0, 0.0f});
+            std::rotate(timeline.begin() + at, timeline.end() - 1, timeline.end());
+            pos = timeline.begin() + at;
+            studentsBySemester[semester].push_back(student);
+        }
+        pos->courses++;
+        pos->points += course.getGradePoints();
+    }
+
+public:
+    // Whether CourseType has semesters to index
+    static constexpr bool supported() { return Traits::hasSemester; }
+
+    // Index every student; throws invalid_argument if CourseType has no semesters
+    template<typename StudentType>
+    void buildIndex(const std::vector<StudentType>& students) {
+        if (!supported()) {
+            throw std::invalid_argument("Semester index needs courses with semesters (IIIT)");
+        }
+        ScopedTimer span("semesters.build", "index");
+        span.arg("students", (long long)students.size());
+        clear();
+        timelines.reserve(students.size());
+        for (size_t i = 0; i < students.size(); i++) {
+            addStudent(static_cast<int>(i), students[i]);
+        }
+    }
+
+    // Index a student stored at index (normally the next one)
+    template<typename StudentType>
+    void addStudent(int index, const StudentType& student) {
+        if (!supported()) {
+            throw std::invalid_argument("Semester index needs courses with semesters (IIIT)");
+        }
+        if (index >= static_cast<int>(timelines.size())) timelines.resize(index + 1);
+        SemesterTimeline& timeline = timelines[index];
+        for (const auto& course : student.getCourses()) record(index, timeline, course);
+        updateCGPA(timeline);
+    }
+
+    // The student at index took one more course
+    void addCourse(int index, const CourseType& course) {
+        if (!supported()) {
+            throw std::invalid_argument("Semester index needs courses with semesters (IIIT)");
+        }
+        if (index >= static_cast<int>(timelines.size())) timelines.resize(index + 1);
+        record(index, timelines[index], course);
+        updateCGPA(timelines[index]);
+    }
+
+    void clear() {
+        timelines.clear();
+        studentsBySemester.clear();
+    }
+
+    size_t getIndexedStudentCount() const { return timelines.size(); }
+
+    // Semesters of one student, ascending (empty if none)
+    const SemesterTimeline& getTimeline(int index) const { return timelines[index]; }
+
+    // Entry of student in semester, or nullptr
+    const SemesterGPA* find(int index, int semester) const {
+        const SemesterTimeline& timeline = timelines[index];
+        for (const SemesterGPA& entry : timeline) {
+            if (entry.semester == semester) return &entry;
+        }
+        return nullptr;
+    }
+
+    // Semesters with at least one course, ascending
+    std::vector<int> getSemesters() const {
+        std::vector<int> semesters;
+        for (const auto& entry : studentsBySemester) semesters.push_back(entry.first);
+        return semesters;
+    }
+
+    // Consecutive semesters (in each student's timeline) where SGPA fell by
+    // more than minDrop; by student, then semester
+    std::vector<SGPADrop> findSGPADrops(double minDrop) const {
+        ScopedTimer span("semesters.sgpa_drops", "search");
+        std::vector<SGPADrop> drops;
+        for (size_t i = 0; i < timelines.size(); i++) {
+            const SemesterTimeline& timeline = timelines[i];
+            for (size_t s = 1; s < timeline.size(); s++) {
+                double before = timeline[s - 1].sgpa();
+                double after = timeline[s].sgpa();
+                if (before - after > minDrop) {
+                    drops.push_back({static_cast<int>(i), timeline[s - 1].semester, timeline[s].semester, before, after});
+                }
+            }
+        }
+        return drops;
+    }
+
+    // The k best SGPAs of a semester; ties by higher CGPA, then storage index
+    std::vector<SemesterRank> topSGPA(int semester, size_t k) const {
+        ScopedTimer span("semesters.top_sgpa", "search");
+        std::vector<SemesterRank> ranks;
+        auto it = studentsBySemester.find(semester);
+        if (it == studentsBySemester.end()) return ranks;
+        ranks.reserve(it->second.size());
+        for (int student : it->second) {
+            const SemesterGPA* entry = find(student, semester);
+            ranks.push_back({student, entry->sgpa(), entry->cgpa});
+        }
+        k = std::min(k, ranks.size());
+        std::partial_sort(ranks.begin(), ranks.begin() + k, ranks.end(),
+            [](const SemesterRank& a, const SemesterRank& b) {
+                if (a.sgpa != b.sgpa) return a.sgpa > b.sgpa;
+                if (a.cgpa != b.cgpa) return a.cgpa > b.cgpa;
+                return a.student < b.student;
+            });
+        ranks.resize(k);
+        return ranks;
+    }
+};
+
+#endif // SEMESTER_INDEX_H
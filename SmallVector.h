@@ -0,0 +1,192 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <stdexcept>
+#include <initializer_list>
+
+// Vector with room for N elements inside the object itself. Up to N
+// elements need no heap allocation and sit next to the owning object; a
+// larger list moves to the heap like std::vector. The inline buffer and
+// the heap pointer share storage, so the overhead over N elements is just
+// the size and capacity words.
+template<typename T, size_t N>
+class SmallVector {
+    static_assert(N > 0, "SmallVector needs an inline capacity of at least 1");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+private:
+    union Storage {
+        alignas(T) unsigned char inlineBytes[N * sizeof(T)];
+        T* heap;
+
+        Storage() {}
+    } storage;
+    uint32_t count;
+    uint32_t cap;       // N while inline
+
+    bool onHeap() const { return cap > N; }
+
+    T* buffer() { return onHeap() ? storage.heap : reinterpret_cast<T*>(storage.inlineBytes); }
+    const T* buffer() const { return onHeap() ? storage.heap : reinterpret_cast<const T*>(storage.inlineBytes); }
+
+    void destroyAll() {
+        std::destroy_n(buffer(), count);
+        if (onHeap()) ::operator delete(storage.heap);
+        count = 0;
+        cap = N;
+    }
+
+    void grow(size_t minCapacity) {
+        if (minCapacity > UINT32_MAX) {
+            throw std::length_error("SmallVector too large");
+        }
+        size_t newCap = std::max<size_t>(minCapacity, std::min<size_t>(2 * size_t(cap), UINT32_MAX));
+        T* fresh = static_cast<T*>(::operator new(newCap * sizeof(T)));
+        T* old = buffer();
+        std::uninitialized_move_n(old, count, fresh);
+        std::destroy_n(old, count);
+        if (onHeap()) ::operator delete(storage.heap);
+        storage.heap = fresh;
+        cap = static_cast<uint32_t>(newCap);
+    }
+
+    // Take over other's elements; this must be empty and inline
+    void steal(SmallVector& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        if (other.onHeap()) {
+            storage.heap = other.storage.heap;
+            count = other.count;
+            cap = other.cap;
+            other.count = 0;
+            other.cap = N;
+        } else {
+            std::uninitialized_move_n(other.buffer(), other.count, buffer());
+            count = other.count;
+            other.clear();
+        }
+    }
+
+public:
+    SmallVector() : count(0), cap(N) {}
+
+    SmallVector(std::initializer_list<T> values) : SmallVector() {
+        reserve(values.size());
+        for (const T& value : values) push_back(value);
+    }
+
+    SmallVector(const SmallVector& other) : SmallVector() {
+        reserve(other.count);
+        std::uninitialized_copy_n(other.buffer(), other.count, buffer());
+        count = other.count;
+    }
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : SmallVector() {
+        steal(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.count);
+            std::uninitialized_copy_n(other.buffer(), other.count, buffer());
+            count = other.count;
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        if (this != &other) {
+            destroyAll();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() { destroyAll(); }
+
+    void push_back(const T& value) {
+        if (count == cap) {
+            T copy(value); // value may live in this vector
+            grow(size_t(count) + 1);
+            ::new (static_cast<void*>(buffer() + count)) T(std::move(copy));
+        } else {
+            ::new (static_cast<void*>(buffer() + count)) T(value);
+        }
+        count++;
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (count == cap) {
+            T value(std::forward<Args>(args)...);
+            grow(size_t(count) + 1);
+            ::new (static_cast<void*>(buffer() + count)) T(std::move(value));
+        } else {
+            ::new (static_cast<void*>(buffer() + count)) T(std::forward<Args>(args)...);
+        }
+        return buffer()[count++];
+    }
+
+    void pop_back() {
+        count--;
+        buffer()[count].~T();
+    }
+
+    void reserve(size_t n) {
+        if (n > cap) grow(n);
+    }
+
+    // Destroys the elements; heap storage, if any, is kept
+    void clear() {
+        std::destroy_n(buffer(), count);
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return cap; }
+    static constexpr size_t inlineCapacity() { return N; }
+
+    // True while the elements live inside the object (no heap allocation)
+    bool isInline() const { return !onHeap(); }
+
+    T* data() { return buffer(); }
+    const T* data() const { return buffer(); }
+
+    T& operator[](size_t i) { return buffer()[i]; }
+    const T& operator[](size_t i) const { return buffer()[i]; }
+
+    T& front() { return buffer()[0]; }
+    const T& front() const { return buffer()[0]; }
+    T& back() { return buffer()[count - 1]; }
+    const T& back() const { return buffer()[count - 1]; }
+
+    iterator begin() { return buffer(); }
+    iterator end() { return buffer() + count; }
+    const_iterator begin() const { return buffer(); }
+    const_iterator end() const { return buffer() + count; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+};
+
+#endif // SMALL_VECTOR_H
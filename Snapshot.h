@@ -0,0 +1,544 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Student.h"
+#include "StudentManager.h"
+#include "SearchIndex.h"
+#include "Metrics.h"
+
+// ============================================================================
+// Binary snapshot format (version 1)
+//
+//   [SnapshotHeader][section 0][section 1]...
+//
+// The header holds a section table; every section is an array of fixed-width
+// little-endian records, 8-byte aligned. All variable-length text (rolls,
+// names, branches, course codes) lives once in the string table and is
+// referenced by (offset, length). Two systems are stored - system 0 is the
+// IIIT manager, system 1 the IIT manager - each with students, a flat
+// course array, the sorted permutation and the search index postings.
+// ============================================================================
+
+const char SNAPSHOT_MAGIC[8] = {'E', 'R', 'P', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+enum SnapshotSectionId {
+    SECTION_STRINGS = 0,
+    SECTION_STUDENTS,      // + 5 * system
+    SECTION_COURSES,
+    SECTION_SORTED,
+    SECTION_INDEX_KEYS,
+    SECTION_POSTINGS,
+    SNAPSHOT_SECTION_COUNT = 1 + 5 * 2
+};
+
+inline int snapshotSection(int system, SnapshotSectionId id) {
+    return id == SECTION_STRINGS ? SECTION_STRINGS : id + 5 * system;
+}
+
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t count;
+    uint64_t recordSize;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t indexedStudents[2];
+    SnapshotSection sections[SNAPSHOT_SECTION_COUNT];
+};
+
+struct SnapshotStudentRecord {
+    uint64_t roll;          // String-table offset, or the roll itself for numeric rolls
+    uint32_t rollLength;
+    int32_t startYear;
+    uint64_t nameOffset;
+    uint32_t nameLength;
+    uint32_t branchLength;
+    uint64_t branchOffset;
+    uint64_t courseBegin;
+    uint32_t courseCount;
+    uint32_t reserved;
+};
+
+struct SnapshotCourseRecord {
+    uint64_t code;          // String-table offset, or the code itself for numeric codes
+    uint32_t codeLength;
+    int32_t semester;
+    char grade;
+    char reserved[7];
+};
+
+struct SnapshotIndexKeyRecord {
+    uint64_t codeOffset;
+    uint32_t codeLength;
+    uint32_t reserved;
+    uint64_t postingBegin;
+    uint64_t postingCount;
+};
+
+struct SnapshotPostingRecord {
+    int32_t studentIndex;
+    int32_t gradePoints;
+};
+
+// String table builder - identical strings (branches, course codes) are stored once
+class SnapshotStringTable {
+private:
+    std::string data;
+    std::unordered_map<std::string, uint64_t> offsets;
+
+public:
+    std::pair<uint64_t, uint32_t> add(const std::string& value) {
+        auto it = offsets.find(value);
+        if (it != offsets.end()) {
+            return {it->second, static_cast<uint32_t>(value.size())};
+        }
+        uint64_t offset = data.size();
+        data.append(value);
+        offsets.emplace(value, offset);
+        return {offset, static_cast<uint32_t>(value.size())};
+    }
+
+    const std::string& bytes() const { return data; }
+};
+
+// Read-only view of the string table of a mapped snapshot
+class SnapshotStringView {
+private:
+    const char* data;
+    uint64_t size;
+
+public:
+    SnapshotStringView(const char* d, uint64_t s) : data(d), size(s) {}
+
+    std::string get(uint64_t offset, uint32_t length) const {
+        if (offset > size || length > size - offset) {
+            throw std::runtime_error("Snapshot string reference out of range");
+        }
+        return std::string(data + offset, length);
+    }
+};
+
+// Roll number encoding, per RollType
+template<typename RollType>
+struct SnapshotRollCodec;
+
+template<>
+struct SnapshotRollCodec<std::string> {
+    static void encode(const std::string& roll, SnapshotStringTable& strings, SnapshotStudentRecord& rec) {
+        auto ref = strings.add(roll);
+        rec.roll = ref.first;
+        rec.rollLength = ref.second;
+    }
+    static std::string decode(const SnapshotStudentRecord& rec, const SnapshotStringView& strings) {
+        return strings.get(rec.roll, rec.rollLength);
+    }
+};
+
+// Same on-disk form as std::string rolls, so snapshots stay compatible
+template<>
+struct SnapshotRollCodec<PackedRoll> {
+    static void encode(const PackedRoll& roll, SnapshotStringTable& strings, SnapshotStudentRecord& rec) {
+        auto ref = strings.add(roll.str());
+        rec.roll = ref.first;
+        rec.rollLength = ref.second;
+    }
+    static PackedRoll decode(const SnapshotStudentRecord& rec, const SnapshotStringView& strings) {
+        return PackedRoll(strings.get(rec.roll, rec.rollLength));
+    }
+};
+
+template<>
+struct SnapshotRollCodec<unsigned int> {
+    static void encode(unsigned int roll, SnapshotStringTable&, SnapshotStudentRecord& rec) {
+        rec.roll = roll;
+        rec.rollLength = 0;
+    }
+    static unsigned int decode(const SnapshotStudentRecord& rec, const SnapshotStringView&) {
+        return static_cast<unsigned int>(rec.roll);
+    }
+};
+
+// Course encoding, per CourseType
+template<typename CourseType>
+struct SnapshotCourseCodec;
+
+template<>
+struct SnapshotCourseCodec<IIITCourse> {
+    static void encode(const IIITCourse& course, SnapshotStringTable& strings, SnapshotCourseRecord& rec) {
+        auto ref = strings.add(course.code);
+        rec.code = ref.first;
+        rec.codeLength = ref.second;
+        rec.semester = course.semester;
+        rec.grade = course.grade;
+    }
+    static IIITCourse decode(const SnapshotCourseRecord& rec, const SnapshotStringView& strings) {
+        return IIITCourse(strings.get(rec.code, rec.codeLength), rec.semester, rec.grade);
+    }
+};
+
+template<>
+struct SnapshotCourseCodec<IITCourse> {
+    static void encode(const IITCourse& course, SnapshotStringTable&, SnapshotCourseRecord& rec) {
+        rec.code = static_cast<uint64_t>(static_cast<int64_t>(course.code));
+        rec.codeLength = 0;
+        rec.semester = 0;
+        rec.grade = course.grade;
+    }
+    static IITCourse decode(const SnapshotCourseRecord& rec, const SnapshotStringView&) {
+        return IITCourse(static_cast<int>(static_cast<int64_t>(rec.code)), rec.grade);
+    }
+};
+
+// Encoded sections of one system, ready to be written
+struct SnapshotSystemData {
+    std::vector<SnapshotStudentRecord> students;
+    std::vector<SnapshotCourseRecord> courses;
+    std::vector<int32_t> sorted;
+    std::vector<SnapshotIndexKeyRecord> indexKeys;
+    std::vector<SnapshotPostingRecord> postings;
+    uint64_t indexedStudents = 0;
+};
+
+template<typename RollType, typename CourseType>
+SnapshotSystemData encodeSnapshotSystem(const StudentManager<RollType, CourseType>& manager,
+                                        const SearchIndex<CourseType>& index,
+                                        SnapshotStringTable& strings) {
+    SnapshotSystemData out;
+    const auto& students = manager.getStudents();
+    out.students.resize(students.size());
+
+    for (size_t i = 0; i < students.size(); i++) {
+        const auto& student = students[i];
+        SnapshotStudentRecord& rec = out.students[i];
+        std::memset(&rec, 0, sizeof(rec));
+
+        SnapshotRollCodec<RollType>::encode(student.getRollNumber(), strings, rec);
+        auto name = strings.add(student.getName());
+        auto branch = strings.add(student.getBranch());
+        rec.nameOffset = name.first;
+        rec.nameLength = name.second;
+        rec.branchOffset = branch.first;
+        rec.branchLength = branch.second;
+        rec.startYear = student.getStartYear();
+        rec.courseBegin = out.courses.size();
+        rec.courseCount = static_cast<uint32_t>(student.getCourses().size());
+
+        for (const auto& course : student.getCourses()) {
+            SnapshotCourseRecord courseRec;
+            std::memset(&courseRec, 0, sizeof(courseRec));
+            SnapshotCourseCodec<CourseType>::encode(course, strings, courseRec);
+            out.courses.push_back(courseRec);
+        }
+    }
+
+    if (manager.hasSortedOrder()) {
+        const auto& order = manager.getSortedOrderIndices();
+        out.sorted.assign(order.begin(), order.end());
+    }
+
+    // Only a current index is worth persisting
+    if (index.getIndexedStudentCount() == students.size() &&
+        index.getCourseVersion() == manager.getCourseVersion()) {
+        for (const auto& entry : index.getEntries()) {
+            SnapshotIndexKeyRecord key;
+            std::memset(&key, 0, sizeof(key));
+            auto code = strings.add(entry.first);
+            key.codeOffset = code.first;
+            key.codeLength = code.second;
+            key.postingBegin = out.postings.size();
+            key.postingCount = entry.second.size();
+            for (const auto& posting : entry.second) {
+                out.postings.push_back({posting.first, posting.second});
+            }
+            out.indexKeys.push_back(key);
+        }
+        out.indexedStudents = students.size();
+    }
+
+    return out;
+}
+
+/**
+ * Write both managers, their sorted permutations and search indexes
+ * into a single binary snapshot file. Throws runtime_error on I/O failure.
+ */
+template<typename R1, typename C1, typename R2, typename C2>
+void saveSnapshot(const std::string& filename,
+                  const StudentManager<R1, C1>& iiit, const SearchIndex<C1>& iiitIndex,
+                  const StudentManager<R2, C2>& iit, const SearchIndex<C2>& iitIndex) {
+    ScopedTimer span("snapshot.save", "snapshot");
+    SnapshotStringTable strings;
+    SnapshotSystemData systems[2] = {
+        encodeSnapshotSystem(iiit, iiitIndex, strings),
+        encodeSnapshotSystem(iit, iitIndex, strings)
+    };
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+
+    // Lay out sections after the header, 8-byte aligned
+    std::vector<std::pair<const char*, uint64_t>> payloads(SNAPSHOT_SECTION_COUNT);
+    payloads[SECTION_STRINGS] = {strings.bytes().data(), strings.bytes().size()};
+    header.sections[SECTION_STRINGS] = {0, strings.bytes().size(), 1};
+
+    for (int sys = 0; sys < 2; sys++) {
+        const SnapshotSystemData& d = systems[sys];
+        header.indexedStudents[sys] = d.indexedStudents;
+
+        auto place = [&](SnapshotSectionId id, const void* data, uint64_t count, uint64_t recordSize) {
+            int section = snapshotSection(sys, id);
+            payloads[section] = {static_cast<const char*>(data), count * recordSize};
+            header.sections[section] = {0, count, recordSize};
+        };
+        place(SECTION_STUDENTS, d.students.data(), d.students.size(), sizeof(SnapshotStudentRecord));
+        place(SECTION_COURSES, d.courses.data(), d.courses.size(), sizeof(SnapshotCourseRecord));
+        place(SECTION_SORTED, d.sorted.data(), d.sorted.size(), sizeof(int32_t));
+        place(SECTION_INDEX_KEYS, d.indexKeys.data(), d.indexKeys.size(), sizeof(SnapshotIndexKeyRecord));
+        place(SECTION_POSTINGS, d.postings.data(), d.postings.size(), sizeof(SnapshotPostingRecord));
+    }
+
+    uint64_t offset = sizeof(SnapshotHeader);
+    for (int i = 0; i < SNAPSHOT_SECTION_COUNT; i++) {
+        offset = (offset + 7) & ~uint64_t(7);
+        header.sections[i].offset = offset;
+        offset += payloads[i].second;
+    }
+    header.fileSize = offset;
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not create snapshot: " + filename);
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    const char padding[8] = {0};
+    for (int i = 0; i < SNAPSHOT_SECTION_COUNT; i++) {
+        out.write(padding, header.sections[i].offset - written);
+        out.write(payloads[i].first, payloads[i].second);
+        written = header.sections[i].offset + payloads[i].second;
+    }
+
+    out.close();
+    if (out.fail()) {
+        throw std::runtime_error("Failed to write snapshot: " + filename);
+    }
+}
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+    int fd;
+    const char* data;
+    size_t size;
+
+public:
+    explicit MappedFile(const std::string& filename) : fd(-1), data(nullptr), size(0) {
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open snapshot: " + filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("Snapshot is empty or unreadable: " + filename);
+        }
+        size = static_cast<size_t>(st.st_size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map snapshot: " + filename);
+        }
+        ::madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+
+    ~MappedFile() {
+        if (data) ::munmap(const_cast<char*>(data), size);
+        if (fd >= 0) ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* bytes() const { return data; }
+    size_t length() const { return size; }
+};
+
+// Typed, bounds-checked access to one section of a mapped snapshot
+template<typename Record>
+const Record* snapshotSectionData(const MappedFile& file, const SnapshotHeader& header, int section) {
+    const SnapshotSection& s = header.sections[section];
+    if (s.count == 0) return nullptr;
+    if (s.recordSize != sizeof(Record) || s.offset % alignof(Record) != 0 ||
+        s.offset > file.length() || s.count > (file.length() - s.offset) / sizeof(Record)) {
+        throw std::runtime_error("Snapshot section " + std::to_string(section) + " is corrupt");
+    }
+    return reinterpret_cast<const Record*>(file.bytes() + s.offset);
+}
+
+// The file stores a numeric-roll row once per system; on load the IIT
+// student reuses the record of its IIIT twin (same roll, name, branch, year)
+class SnapshotRecordSharing {
+private:
+    std::unordered_map<unsigned int, StudentRecordRef> byRoll;
+
+public:
+    StudentRecordRef share(const PackedRoll& roll, const std::string& name, const std::string& branch, int year) {
+        StudentRecordRef record = StudentRecordRef::make(name, branch, year);
+        char buffer[PackedRoll::MAX_LENGTH];
+        std::string_view text = roll.view(buffer);
+        const char* digits = text.data();
+        const char* end = digits + text.size();
+        unsigned int value;
+        auto parsed = std::from_chars(digits, end, value);
+        if (end != digits && parsed.ec == std::errc() && parsed.ptr == end) {
+            byRoll.emplace(value, record);
+        }
+        return record;
+    }
+
+    StudentRecordRef share(unsigned int roll, const std::string& name, const std::string& branch, int year) {
+        auto it = byRoll.find(roll);
+        if (it != byRoll.end() && it->second->name == name && *it->second->branch == branch &&
+            it->second->startYear == year) {
+            return it->second;
+        }
+        return StudentRecordRef::make(name, branch, year);
+    }
+};
+
+template<typename RollType, typename CourseType>
+void decodeSnapshotSystem(const MappedFile& file, const SnapshotHeader& header, int sys,
+                          const SnapshotStringView& strings,
+                          StudentManager<RollType, CourseType>& manager,
+                          SearchIndex<CourseType>& index, SnapshotRecordSharing& sharing) {
+    uint64_t studentCount = header.sections[snapshotSection(sys, SECTION_STUDENTS)].count;
+    uint64_t courseCount = header.sections[snapshotSection(sys, SECTION_COURSES)].count;
+    const auto* students = snapshotSectionData<SnapshotStudentRecord>(file, header, snapshotSection(sys, SECTION_STUDENTS));
+    const auto* courses = snapshotSectionData<SnapshotCourseRecord>(file, header, snapshotSection(sys, SECTION_COURSES));
+
+    manager.reserve(studentCount);
+    for (uint64_t i = 0; i < studentCount; i++) {
+        const SnapshotStudentRecord& rec = students[i];
+        if (rec.courseBegin > courseCount || rec.courseCount > courseCount - rec.courseBegin) {
+            throw std::runtime_error("Snapshot course range out of bounds");
+        }
+
+        RollType roll = SnapshotRollCodec<RollType>::decode(rec, strings);
+        StudentRecordRef record = sharing.share(roll, strings.get(rec.nameOffset, rec.nameLength),
+                                                strings.get(rec.branchOffset, rec.branchLength),
+                                                rec.startYear);
+        Student<RollType, CourseType> student(std::move(roll), std::move(record));
+        for (uint32_t c = 0; c < rec.courseCount; c++) {
+            student.addCourse(SnapshotCourseCodec<CourseType>::decode(courses[rec.courseBegin + c], strings));
+        }
+        manager.addStudent(std::move(student));
+    }
+
+    uint64_t sortedCount = header.sections[snapshotSection(sys, SECTION_SORTED)].count;
+    if (sortedCount > 0) {
+        const auto* sorted = snapshotSectionData<int32_t>(file, header, snapshotSection(sys, SECTION_SORTED));
+        // restoreSortedOrder rejects an order that is not a permutation
+        manager.restoreSortedOrder(std::vector<int>(sorted, sorted + sortedCount));
+    }
+
+    uint64_t keyCount = header.sections[snapshotSection(sys, SECTION_INDEX_KEYS)].count;
+    uint64_t postingCount = header.sections[snapshotSection(sys, SECTION_POSTINGS)].count;
+    const auto* keys = snapshotSectionData<SnapshotIndexKeyRecord>(file, header, snapshotSection(sys, SECTION_INDEX_KEYS));
+    const auto* postings = snapshotSectionData<SnapshotPostingRecord>(file, header, snapshotSection(sys, SECTION_POSTINGS));
+    for (uint64_t k = 0; k < keyCount; k++) {
+        const SnapshotIndexKeyRecord& key = keys[k];
+        if (key.postingBegin > postingCount || key.postingCount > postingCount - key.postingBegin) {
+            throw std::runtime_error("Snapshot index postings out of bounds");
+        }
+        std::vector<std::pair<int, int>> list;
+        list.reserve(key.postingCount);
+        for (uint64_t p = 0; p < key.postingCount; p++) {
+            const SnapshotPostingRecord& posting = postings[key.postingBegin + p];
+            if (posting.studentIndex < 0 || static_cast<uint64_t>(posting.studentIndex) >= studentCount) {
+                throw std::runtime_error("Snapshot index posting out of range");
+            }
+            list.push_back({posting.studentIndex, posting.gradePoints});
+        }
+        index.addPostings(strings.get(key.codeOffset, key.codeLength), std::move(list));
+    }
+    if (header.indexedStudents[sys] > studentCount) {
+        throw std::runtime_error("Snapshot index covers more students than it holds");
+    }
+    index.setIndexedStudentCount(header.indexedStudents[sys]);
+}
+
+/**
+ * Load a snapshot written by saveSnapshot. The file is memory-mapped and
+ * decoded directly from its fixed-width records - no text parsing. The
+ * given managers and indexes are replaced only if the whole file loads.
+ */
+template<typename R1, typename C1, typename R2, typename C2>
+void loadSnapshot(const std::string& filename,
+                  StudentManager<R1, C1>& iiit, SearchIndex<C1>& iiitIndex,
+                  StudentManager<R2, C2>& iit, SearchIndex<C2>& iitIndex) {
+    ScopedTimer span("snapshot.load", "snapshot");
+    MappedFile file(filename);
+    if (file.length() < sizeof(SnapshotHeader)) {
+        throw std::runtime_error("Not a snapshot file: " + filename);
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, file.bytes(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a snapshot file: " + filename);
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(header.version));
+    }
+    if (header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+        throw std::runtime_error("Snapshot was written on a machine with different byte order");
+    }
+    if (header.fileSize != file.length()) {
+        throw std::runtime_error("Snapshot is truncated: " + filename);
+    }
+
+    const SnapshotSection& stringSection = header.sections[SECTION_STRINGS];
+    if (stringSection.offset > file.length() || stringSection.count > file.length() - stringSection.offset) {
+        throw std::runtime_error("Snapshot string table is corrupt");
+    }
+    SnapshotStringView strings(file.bytes() + stringSection.offset, stringSection.count);
+
+    StudentManager<R1, C1> newIIIT;
+    StudentManager<R2, C2> newIIT;
+    SearchIndex<C1> newIIITIndex;
+    SearchIndex<C2> newIITIndex;
+    SnapshotRecordSharing sharing;
+    decodeSnapshotSystem(file, header, 0, strings, newIIIT, newIIITIndex, sharing);
+    decodeSnapshotSystem(file, header, 1, strings, newIIT, newIITIndex, sharing);
+
+    iiit = std::move(newIIIT);
+    iit = std::move(newIIT);
+    iiitIndex = std::move(newIIITIndex);
+    iitIndex = std::move(newIITIndex);
+}
+
+#endif // SNAPSHOT_H
@@ -2,78 +2,346 @@
 #define SORTING_THREADS_H
 
 #include <thread>
-#include <mutex>
 #include <vector>
 #include <chrono>
 #include <iostream>
 #include <iomanip>
-#include <fstream>
+#include <sstream>
 #include <ctime>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <memory>
+#include <new>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <time.h>
+#include "Metrics.h"
+#include "CpuTopology.h"
+
+// How parallelSort splits the work between threads and sorts each part
+enum class SortStrategy {
+    MergeSort,      // Segments by top-down merge sort, then merged: O(n log n) whatever the input order
+    NaturalMerge,   // Segments keep the runs already in the input: near-linear when sorted or nearly sorted
+    SampleSort      // Buckets split by sampled keys, each sorted into its final range: no merge phase
+};
+
+inline const char* sortStrategyName(SortStrategy strategy) {
+    switch (strategy) {
+        case SortStrategy::NaturalMerge: return "natural";
+        case SortStrategy::SampleSort: return "sample";
+        case SortStrategy::MergeSort: break;
+    }
+    return "merge";
+}
+
+// Throws invalid_argument on an unknown name
+inline SortStrategy parseSortStrategy(const std::string& name) {
+    if (name == "natural") return SortStrategy::NaturalMerge;
+    if (name == "merge") return SortStrategy::MergeSort;
+    if (name == "sample") return SortStrategy::SampleSort;
+    throw std::invalid_argument("Unknown sort strategy '" + name + "' (use natural/merge/sample)");
+}
+
+// Per-thread timing and work counters for the parallel sort phase
+struct ThreadStats {
+    int threadId;
+    long long startNs;     // Relative to the start of parallelSort
+    long long endNs;
+    long long cpuNs;       // CPU time consumed by the thread
+    int recordsProcessed;
+    unsigned long long comparisons;
+    unsigned long long moves;
+    int runs;              // Natural runs found in the segment (NaturalMerge only)
+    int mergesSkipped;     // Run pairs already in order, left untouched
+    int cpu;               // CPU the thread finished on
+
+    long long getDurationNs() const {
+        return endNs - startNs;
+    }
+
+    double getDurationMs() const {
+        return (endNs - startNs) / 1e6;
+    }
+};
+
+// One level of the serial merge phase (all merges of runs of one size)
+struct MergeLevelStats {
+    int level;
+    int runSize;
+    int merges;
+    int skipped;           // Segment pairs already in order (NaturalMerge only)
+    long long durationNs;
+    unsigned long long comparisons;
+    unsigned long long moves;
+};
+
+// How parallelSort split the work: the requested or automatically chosen
+// thread count, and the cost model behind an automatic choice
+struct SortPlan {
+    bool automatic = false;      // Thread count chosen by the cost model
+    bool sequential = false;     // One thread: sorted in the calling thread, nothing spawned
+    int requestedThreads = 0;    // 0 = auto
+    int hardwareThreads = 1;
+    int threads = 1;
+    double nsPerRecordLevel = 0; // Calibrated sort cost per record per log2(n) level
+    long long spawnNs = 0;       // Measured cost of starting and joining a thread
+    long long estimatedNs = 0;   // Model estimate for the chosen thread count
+    bool pinned = false;         // Workers bound to CPUs (setPinThreads)
+    int numaNodes = 1;           // Nodes the pinned workers were spread over
+    int pinFailures = 0;         // Workers the kernel refused to pin (they ran unpinned)
+};
+
+// Breakdown of the last parallelSort call
+struct SortReport {
+    size_t records = 0;
+    int threads = 0;
+    SortStrategy strategy = SortStrategy::MergeSort;
+    SortPlan plan;
+    long long partitionNs = 0;   // Computing segment bounds (sample sort: sampling + bucketing) + spawning threads
+    long long sortPhaseNs = 0;   // First thread start to last thread end
+    long long mergePhaseNs = 0;  // Serial merge of the sorted segments
+    long long totalWallNs = 0;
+    long long totalCpuNs = 0;    // Process CPU time over the whole call
+    unsigned long long comparisons = 0;
+    unsigned long long moves = 0;
+    long long runs = 0;          // Natural runs found by all threads
+    long long mergesSkipped = 0; // Merges avoided because the runs were already in order
+    double imbalance = 0.0;      // Slowest thread / mean thread time (1.0 = perfect)
+    double idleFraction = 0.0;   // Share of thread-time spent waiting for the slowest thread
+    std::vector<ThreadStats> threadStats;
+    std::vector<MergeLevelStats> mergeLevels;
+};
+
+// Stats slot owned by one sort thread, padded to a cache line so threads
+// writing their results never share a line (no lock, no false sharing)
+struct alignas(64) ThreadStatSlot {
+    ThreadStats stats;
+    bool used = false;
+};
 
 class SortingThreadsManager {
 private:
-    struct ThreadStats {
-        int threadId;
-        long long startTime;
-        long long endTime;
-        int recordsProcessed;
+    // Work counters threaded through the merge sort recursion
+    struct SortCounters {
+        unsigned long long comparisons = 0;
+        unsigned long long moves = 0;
+        int runs = 0;
+        int mergesSkipped = 0;
+    };
 
-        long long getDurationMs() const {
-            return endTime - startTime;
-        }
+    // Natural runs shorter than this are extended by binary insertion sort
+    static constexpr int MIN_RUN = 32;
+
+    // Sample sort draws this many keys per bucket to pick the splitters
+    static constexpr size_t SAMPLES_PER_BUCKET = 64;
+
+    // Auto mode gives every thread at least this many records, so smaller
+    // inputs are sorted sequentially
+    static constexpr size_t MIN_RECORDS_PER_THREAD = 4096;
+
+    // Sorts smaller than this are too noisy to recalibrate the cost model
+    static constexpr size_t CALIBRATION_MIN_RECORDS = 16384;
+
+    // First-touch granularity for NUMA placement of scratch buffers
+    static constexpr size_t PAGE_BYTES = 4096;
+
+    // Uninitialised storage for n elements; constructing and destroying
+    // them is up to the user
+    template<typename T>
+    struct RawBuffer {
+        T* data;
+        size_t size;
+        explicit RawBuffer(size_t n) : data(std::allocator<T>().allocate(n)), size(n) {}
+        ~RawBuffer() { std::allocator<T>().deallocate(data, size); }
+        RawBuffer(const RawBuffer&) = delete;
+        RawBuffer& operator=(const RawBuffer&) = delete;
     };
 
-    std::vector<ThreadStats> threadStats;
-    std::mutex statsMutex;
+    SortReport report;
+    std::vector<ThreadStatSlot> statSlots; // Indexed by threadId, sized before threads start
+    std::chrono::steady_clock::time_point sortStart;
+    bool verbose; // Print progress and statistics to stdout
+    std::string logPath; // Per-sort log file, empty = no log
+    SortStrategy strategy;
+    int hardwareThreadsOverride; // 0 = std::thread::hardware_concurrency()
+    double nsPerRecordLevel;     // Cost model, refined after every large sort
+    bool pinThreads;             // Bind worker threads to CPUs
+    std::vector<int> cpuOfThread; // Placement of the current sort, empty = not pinned
+    std::atomic<int> pinFailures;
+
+    static long long cpuTimeNs(clockid_t clock) {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    long long nsSinceStart() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - sortStart).count();
+    }
 
 public:
-    SortingThreadsManager() {}
+    // Pass as numThreads to let parallelSort pick the thread count
+    static constexpr int AUTO_THREADS = 0;
 
-    // Merge sort implementation for use in threads
-    template<typename T>
-    void mergeSort(std::vector<T>& arr, int left, int right, int threadId, [[maybe_unused]] int totalRecords) {
-        auto startTime = std::chrono::high_resolution_clock::now();
-        long long startMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-            startTime.time_since_epoch()).count();
+    // Upper bound on any thread count, requested or automatic
+    static constexpr int MAX_THREADS = 256;
 
-        mergeSortUtil(arr, left, right);
+    SortingThreadsManager() : sortStart(std::chrono::steady_clock::now()), verbose(true),
+                              logPath("sorting_thread_log.txt"), strategy(SortStrategy::NaturalMerge),
+                              hardwareThreadsOverride(0), nsPerRecordLevel(50.0), pinThreads(false), pinFailures(0) {}
 
-        auto endTime = std::chrono::high_resolution_clock::now();
-        long long endMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-            endTime.time_since_epoch()).count();
+    void setVerbose(bool enabled) { verbose = enabled; }
+    void setLogFile(const std::string& path) { logPath = path; }
+    void setStrategy(SortStrategy s) { strategy = s; }
+    SortStrategy getStrategy() const { return strategy; }
+
+    // Hardware threads assumed by auto mode (e.g. a container's CPU quota);
+    // 0 = std::thread::hardware_concurrency()
+    void setHardwareThreads(int threads) { hardwareThreadsOverride = threads < 0 ? 0 : threads; }
+
+    // Pin worker i to a CPU (pthread_setaffinity_np), spreading the workers
+    // evenly over the NUMA nodes; sample sort also first-touches each
+    // bucket's scratch pages from the worker that sorts it
+    void setPinThreads(bool enabled) { pinThreads = enabled; }
+    bool getPinThreads() const { return pinThreads; }
+
+    int getHardwareThreads() const {
+        if (hardwareThreadsOverride > 0) return hardwareThreadsOverride;
+        unsigned int detected = std::thread::hardware_concurrency();
+        return detected == 0 ? 1 : static_cast<int>(detected);
+    }
 
-        // Record statistics
-        {
-            std::lock_guard<std::mutex> lock(statsMutex);
-            ThreadStats stats;
-            stats.threadId = threadId;
-            stats.startTime = startMs;
-            stats.endTime = endMs;
-            stats.recordsProcessed = (right - left + 1);
-            threadStats.push_back(stats);
+    // Cost of starting and joining one thread, measured once per process
+    static long long threadSpawnNs() {
+        static const long long measured = [] {
+            const int samples = 8;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < samples; i++) {
+                std::thread([] {}).join();
+            }
+            long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count() / samples;
+            return std::max(ns, 1000LL);
+        }();
+        return measured;
+    }
+
+    // Thread count for sorting records with sortStrategy. requestedThreads > 0
+    // is honoured (capped by the record count and MAX_THREADS); AUTO_THREADS
+    // picks the count with the lowest estimated wall time:
+    //   segments: c*n*log2(n/t)/t + c*n*log2(t) (serial merge) + t*spawn
+    //   sample:   c*n*log2(n/t)/t + c*n*log2(t)/t (bucketing) + 3*t*spawn
+    // where c is calibrated from previous sorts, t is at most the hardware
+    // threads, and every thread gets at least MIN_RECORDS_PER_THREAD records.
+    SortPlan planSort(size_t records, int requestedThreads, SortStrategy sortStrategy) const {
+        SortPlan plan;
+        plan.requestedThreads = requestedThreads > 0 ? requestedThreads : AUTO_THREADS;
+        plan.hardwareThreads = getHardwareThreads();
+        plan.nsPerRecordLevel = nsPerRecordLevel;
+        plan.spawnNs = threadSpawnNs();
+
+        double n = static_cast<double>(std::max<size_t>(records, 2));
+        bool sample = sortStrategy == SortStrategy::SampleSort;
+        auto estimate = [&](int t) {
+            if (t <= 1) return nsPerRecordLevel * n * std::log2(n);
+            double levels = std::max(1.0, std::log2(n / t));
+            double split = nsPerRecordLevel * n * std::log2(t) / (sample ? t : 1);
+            return nsPerRecordLevel * n * levels / t + split + (sample ? 3.0 : 1.0) * t * plan.spawnNs;
+        };
+
+        int limit = static_cast<int>(std::min<size_t>(std::max<size_t>(records, 1), MAX_THREADS));
+        if (requestedThreads > 0) {
+            plan.threads = std::min(requestedThreads, limit);
+        } else {
+            plan.automatic = true;
+            int maxThreads = static_cast<int>(std::min<size_t>(
+                {static_cast<size_t>(plan.hardwareThreads), static_cast<size_t>(limit),
+                 std::max<size_t>(records / MIN_RECORDS_PER_THREAD, 1)}));
+            plan.threads = 1;
+            for (int t = 2; t <= maxThreads; t++) {
+                if (estimate(t) < estimate(plan.threads)) plan.threads = t;
+            }
         }
+        plan.sequential = plan.threads == 1;
+        plan.estimatedNs = static_cast<long long>(estimate(plan.threads));
+        return plan;
+    }
+
+    // Breakdown of the most recent parallelSort
+    const SortReport& getLastReport() const { return report; }
+
+    // Merge sort implementation for use in threads
+    template<typename T, typename Compare = std::less<T>>
+    void mergeSort(std::vector<T>& arr, int left, int right, int threadId, [[maybe_unused]] int totalRecords,
+                   Compare comp = Compare()) {
+        timedSegment(threadId, right - left + 1, "sort.segment", [&](SortCounters& counters) {
+            if (report.strategy == SortStrategy::MergeSort) {
+                mergeSortUtil(arr, left, right, comp, counters);
+            } else {
+                naturalMergeSort(arr, left, right, comp, counters);
+            }
+        });
     }
 
 private:
+    // Run one thread's share of the sort and record its statistics
+    template<typename Work>
+    void timedSegment(int threadId, int records, const char* spanName, Work work) {
+        if (!report.plan.sequential) {
+            Metrics::instance().setThreadName("sort-worker-" + std::to_string(threadId));
+        }
+        ScopedTimer span(spanName, "sort");
+        span.arg("thread", threadId);
+        span.arg("records", records);
+        long long startNs = nsSinceStart();
+        long long cpuStart = cpuTimeNs(CLOCK_THREAD_CPUTIME_ID);
+
+        SortCounters counters;
+        work(counters);
+
+        long long cpuNs = cpuTimeNs(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+        long long endNs = nsSinceStart();
+
+        // Record statistics in this thread's own slot; collected after join
+        if (threadId < 0 || threadId >= (int)statSlots.size()) return;
+        ThreadStatSlot& slot = statSlots[threadId];
+        slot.stats.threadId = threadId;
+        slot.stats.startNs = startNs;
+        slot.stats.endNs = endNs;
+        slot.stats.cpuNs = cpuNs;
+        slot.stats.recordsProcessed = records;
+        slot.stats.comparisons = counters.comparisons;
+        slot.stats.moves = counters.moves;
+        slot.stats.runs = counters.runs;
+        slot.stats.mergesSkipped = counters.mergesSkipped;
+        slot.stats.cpu = sched_getcpu();
+        slot.used = true;
+    }
+
     // Utility merge sort function
-    template<typename T>
-    void mergeSortUtil(std::vector<T>& arr, int left, int right) {
+    template<typename T, typename Compare>
+    void mergeSortUtil(std::vector<T>& arr, int left, int right, Compare& comp, SortCounters& counters) {
         if (left < right) {
             int mid = left + (right - left) / 2;
-            mergeSortUtil(arr, left, mid);
-            mergeSortUtil(arr, mid + 1, right);
-            merge(arr, left, mid, right);
+            mergeSortUtil(arr, left, mid, comp, counters);
+            mergeSortUtil(arr, mid + 1, right, comp, counters);
+            merge(arr, left, mid, right, comp, counters);
         }
     }
 
     // Merge function
-    template<typename T>
-    void merge(std::vector<T>& arr, int left, int mid, int right) {
+    template<typename T, typename Compare>
+    void merge(std::vector<T>& arr, int left, int mid, int right, Compare& comp, SortCounters& counters) {
         std::vector<T> temp(right - left + 1);
         int i = left, j = mid + 1, k = 0;
 
         while (i <= mid && j <= right) {
-            if (arr[i] < arr[j]) {
+            counters.comparisons++;
+            if (comp(arr[i], arr[j])) {
                 temp[k++] = arr[i++];
             } else {
                 temp[k++] = arr[j++];
@@ -91,81 +359,527 @@ private:
         for (int idx = 0; idx < k; idx++) {
             arr[left + idx] = temp[idx];
         }
+        counters.moves += 2ULL * k;
     }
 
-public:
-    // Parallel sorting with multiple threads
-    template<typename T>
-    void parallelSort(std::vector<T>& data, int numThreads = 2) {
-        threadStats.clear();
+    // Natural merge sort of arr[left..right] (stable). Ascending runs are kept
+    // as they are, strictly descending ones reversed, runs shorter than
+    // MIN_RUN extended by binary insertion, then neighbouring runs merged
+    // pairwise until one is left. A sorted segment costs n - 1 comparisons.
+    template<typename T, typename Compare>
+    void naturalMergeSort(std::vector<T>& arr, int left, int right, Compare& comp, SortCounters& counters) {
+        auto less = [&](const T& a, const T& b) {
+            counters.comparisons++;
+            return comp(a, b);
+        };
+        auto at = [&](int i) { return arr.begin() + i; };
+
+        std::vector<int> bounds{left};  // Run starts, then right + 1
+        int end = right + 1;
+        int start = left;
+        while (start < end) {
+            int next = start + 1;
+            if (next < end) {
+                if (less(arr[next], arr[start])) {
+                    for (next++; next < end && less(arr[next], arr[next - 1]); next++) {}
+                    std::reverse(at(start), at(next));
+                    counters.moves += next - start;
+                } else {
+                    for (next++; next < end && !less(arr[next], arr[next - 1]); next++) {}
+                }
+            }
+            counters.runs++;
+
+            int target = std::min(end, start + MIN_RUN);
+            for (; next < target; next++) {
+                auto pos = std::upper_bound(at(start), at(next), arr[next], less);
+                if (pos == at(next)) continue;
+                T value = std::move(arr[next]);
+                std::move_backward(pos, at(next), at(next + 1));
+                *pos = std::move(value);
+                counters.moves += (at(next) - pos) + 2;
+            }
+            bounds.push_back(next);
+            start = next;
+        }
+
+        std::vector<T> buffer;
+        while (bounds.size() > 2) {
+            std::vector<int> merged{bounds[0]};
+            size_t r = 0;
+            for (; r + 2 < bounds.size(); r += 2) {
+                mergeRuns(arr, bounds[r], bounds[r + 1], bounds[r + 2], buffer, less, counters);
+                merged.push_back(bounds[r + 2]);
+            }
+            if (r + 2 == bounds.size()) merged.push_back(bounds.back()); // Odd run out
+            bounds.swap(merged);
+        }
+    }
+
+    // Stable in-place merge of the sorted runs [lo, mid) and [mid, hi),
+    // buffering only the part of the left run that actually moves. Returns
+    // false (nothing done) if the runs are already in order.
+    template<typename T, typename Less>
+    bool mergeRuns(std::vector<T>& arr, int lo, int mid, int hi, std::vector<T>& buffer,
+                   Less& less, SortCounters& counters) {
+        if (lo >= mid || mid >= hi || !less(arr[mid], arr[mid - 1])) {
+            counters.mergesSkipped++;
+            return false;
+        }
+        // Left elements <= the first right one and right elements >= the
+        // last left one are already in their final place
+        int first = static_cast<int>(std::upper_bound(arr.begin() + lo, arr.begin() + mid, arr[mid], less) - arr.begin());
+        int last = static_cast<int>(std::lower_bound(arr.begin() + mid, arr.begin() + hi, arr[mid - 1], less) - arr.begin());
+
+        buffer.assign(std::make_move_iterator(arr.begin() + first), std::make_move_iterator(arr.begin() + mid));
+        size_t b = 0;
+        int r = mid, out = first;
+        while (b < buffer.size() && r < last) {
+            if (less(arr[r], buffer[b])) {
+                arr[out++] = std::move(arr[r++]);
+            } else {
+                arr[out++] = std::move(buffer[b++]);
+            }
+        }
+        while (b < buffer.size()) {
+            arr[out++] = std::move(buffer[b++]);
+        }
+        counters.moves += buffer.size() + (out - first);
+        buffer.clear();
+        return true;
+    }
 
-        if (numThreads < 2) numThreads = 2;
-        if (numThreads > (int)data.size()) numThreads = data.size();
+    // Whether data[a] sorts before data[b]: by comp, ties by position (so
+    // equal keys can be split between buckets without losing stability)
+    template<typename T, typename Compare>
+    static bool precedes(const std::vector<T>& data, size_t a, size_t b, Compare& comp, SortCounters& counters) {
+        counters.comparisons++;
+        if (comp(data[a], data[b])) return true;
+        counters.comparisons++;
+        if (comp(data[b], data[a])) return false;
+        return a < b;
+    }
+
+    // Bind the calling worker to its CPU in the current placement, if any
+    void pinWorker(int threadId) {
+        if (threadId >= 0 && threadId < (int)cpuOfThread.size() &&
+            !CpuTopology::pinCurrentThread(cpuOfThread[threadId])) {
+            pinFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 
+    template<typename Work>
+    void runThreads(int count, Work work) {
         std::vector<std::thread> threads;
-        int recordsPerThread = data.size() / numThreads;
+        for (int t = 0; t < count; t++) {
+            threads.emplace_back([this, &work, t] {
+                pinWorker(t);
+                work(t);
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    // One thread: sort in the calling thread, no threads spawned
+    template<typename T, typename Compare>
+    void sequentialSort(std::vector<T>& data, Compare& comp) {
+        int last = static_cast<int>(data.size()) - 1;
+        timedSegment(0, last + 1, "sort.sequential", [&](SortCounters& counters) {
+            if (report.strategy == SortStrategy::MergeSort) {
+                mergeSortUtil(data, 0, last, comp, counters);
+            } else {
+                naturalMergeSort(data, 0, last, comp, counters);
+            }
+        });
+        collectThreadStats();
+    }
+
+    // Refine the cost model from the CPU time of the sort just finished
+    void calibrate() {
+        if (report.records < CALIBRATION_MIN_RECORDS || report.totalCpuNs <= 0) return;
+        double n = static_cast<double>(report.records);
+        double observed = report.totalCpuNs / (n * std::log2(n));
+        nsPerRecordLevel = 0.5 * nsPerRecordLevel + 0.5 * observed;
+    }
 
-        std::cout << "\n=== Starting Parallel Sort ===" << std::endl;
-        std::cout << "Total Records: " << data.size() << std::endl;
-        std::cout << "Number of Threads: " << numThreads << std::endl;
-        std::cout << "Records per thread (approx): " << recordsPerThread << std::endl;
+    // Segments sorted in parallel, then merged level by level
+    template<typename T, typename Compare>
+    void segmentSort(std::vector<T>& data, int numThreads, Compare& comp) {
+        std::vector<std::thread> threads;
+        int recordsPerThread = data.size() / numThreads;
 
         // Create and launch threads
         for (int i = 0; i < numThreads; i++) {
             int start = i * recordsPerThread;
             int end = (i == numThreads - 1) ? (data.size() - 1) : ((i + 1) * recordsPerThread - 1);
 
-            threads.emplace_back(&SortingThreadsManager::mergeSort<T>, this,
-                std::ref(data), start, end, i, (int)data.size());
+            threads.emplace_back([this, &data, &comp, start, end, i] {
+                pinWorker(i);
+                mergeSort(data, start, end, i, (int)data.size(), comp);
+            });
         }
+        report.partitionNs = nsSinceStart();
 
         // Wait for all threads to complete
         for (auto& t : threads) {
             t.join();
         }
+        collectThreadStats();
 
         // Now merge the sorted segments
+        long long mergeStart = nsSinceStart();
+        int level = 0;
+        bool natural = report.strategy == SortStrategy::NaturalMerge;
+        std::vector<T> buffer;
         for (int size = recordsPerThread; size < (int)data.size(); size *= 2) {
+            ScopedTimer levelSpan("sort.merge_level", "sort");
+            levelSpan.arg("run_size", size);
+            long long levelStart = nsSinceStart();
+            SortCounters counters;
+            int merges = 0;
             for (int start = 0; start < (int)data.size(); start += size * 2) {
                 int mid = start + size - 1;
                 int end = std::min(start + size * 2 - 1, (int)data.size() - 1);
-                if (mid < end) {
-                    merge(data, start, mid, end);
+                if (mid >= end) continue;
+                if (!natural) {
+                    merge(data, start, mid, end, comp, counters);
+                    merges++;
+                } else {
+                    auto counted = [&](const T& a, const T& b) {
+                        counters.comparisons++;
+                        return comp(a, b);
+                    };
+                    if (mergeRuns(data, start, mid + 1, end + 1, buffer, counted, counters)) merges++;
                 }
             }
+            report.mergeLevels.push_back({level++, size, merges, counters.mergesSkipped, nsSinceStart() - levelStart,
+                                          counters.comparisons, counters.moves});
+        }
+        report.mergePhaseNs = nsSinceStart() - mergeStart;
+    }
+
+    // Sample sort with one bucket per thread. Splitters come from a sorted
+    // pseudo-random sample; each thread classifies its slice of the input,
+    // then scatters it into a shared buffer at per-(thread, bucket) offsets,
+    // and finally every thread moves one bucket back into its final range
+    // and sorts it there (natural merge). Stable, and no merge phase.
+    template<typename T, typename Compare>
+    void sampleSort(std::vector<T>& data, int buckets, Compare& comp) {
+        const size_t n = data.size();
+        SortCounters partitionCounters;
+
+        size_t sampleSize = std::min(n, static_cast<size_t>(buckets) * SAMPLES_PER_BUCKET);
+        std::vector<size_t> sample(sampleSize);
+        uint64_t state = n;
+        for (size_t& index : sample) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            index = static_cast<size_t>((state >> 33) % n);
+        }
+        std::sort(sample.begin(), sample.end(), [&](size_t a, size_t b) {
+            return precedes(data, a, b, comp, partitionCounters);
+        });
+        std::vector<size_t> splitters(buckets - 1);
+        for (int b = 1; b < buckets; b++) {
+            splitters[b - 1] = sample[b * sampleSize / buckets];
         }
 
+        // Bucket of every element, and per thread how many go to each bucket
+        auto sliceBegin = [&](int t) { return n * t / buckets; };
+        std::vector<uint32_t> bucketOf(n);
+        std::vector<std::vector<size_t>> counts(buckets);
+        std::vector<unsigned long long> classifyComparisons(buckets);
+        runThreads(buckets, [&](int t) {
+            SortCounters counters;
+            std::vector<size_t> local(buckets, 0);
+            for (size_t i = sliceBegin(t); i < sliceBegin(t + 1); i++) {
+                size_t lo = 0, hi = splitters.size();  // First splitter that element i precedes
+                while (lo < hi) {
+                    size_t mid = (lo + hi) / 2;
+                    if (precedes(data, i, splitters[mid], comp, counters)) hi = mid;
+                    else lo = mid + 1;
+                }
+                bucketOf[i] = static_cast<uint32_t>(lo);
+                local[lo]++;
+            }
+            counts[t] = std::move(local);
+            classifyComparisons[t] = counters.comparisons;
+        });
+
+        // Bucket ranges; counts[t][b] becomes thread t's first slot in bucket b
+        std::vector<size_t> bucketStart(buckets + 1, 0);
+        for (int b = 0; b < buckets; b++) {
+            size_t pos = bucketStart[b];
+            for (int t = 0; t < buckets; t++) {
+                size_t count = counts[t][b];
+                counts[t][b] = pos;
+                pos += count;
+            }
+            bucketStart[b + 1] = pos;
+        }
+
+        RawBuffer<T> buffer(n);
+        if (report.plan.numaNodes > 1) {
+            // The scatter writes every bucket from every thread; touch each
+            // bucket's pages first from its own (pinned) thread so they are
+            // allocated on the node that sorts the bucket
+            runThreads(buckets, [&](int b) {
+                char* first = reinterpret_cast<char*>(buffer.data + bucketStart[b]);
+                char* last = reinterpret_cast<char*>(buffer.data + bucketStart[b + 1]);
+                for (char* page = first; page < last; page += PAGE_BYTES) *page = 0;
+            });
+        }
+        runThreads(buckets, [&](int t) {
+            std::vector<size_t>& next = counts[t];
+            for (size_t i = sliceBegin(t); i < sliceBegin(t + 1); i++) {
+                ::new (static_cast<void*>(buffer.data + next[bucketOf[i]]++)) T(std::move(data[i]));
+            }
+        });
+        report.partitionNs = nsSinceStart();
+
+        runThreads(buckets, [&](int b) {
+            size_t lo = bucketStart[b], hi = bucketStart[b + 1];
+            timedSegment(b, static_cast<int>(hi - lo), "sort.bucket", [&](SortCounters& counters) {
+                for (size_t k = lo; k < hi; k++) {
+                    data[k] = std::move(buffer.data[k]);
+                    buffer.data[k].~T();
+                }
+                counters.moves += 2 * (hi - lo);  // Scatter + move back
+                if (hi - lo > 1) {
+                    naturalMergeSort(data, static_cast<int>(lo), static_cast<int>(hi - 1), comp, counters);
+                }
+            });
+        });
+        collectThreadStats();
+
+        for (unsigned long long comparisons : classifyComparisons) {
+            partitionCounters.comparisons += comparisons;
+        }
+        report.comparisons += partitionCounters.comparisons;
+    }
+
+    // Gather the per-thread slots; only called once every thread has been joined
+    void collectThreadStats() {
+        for (const auto& slot : statSlots) {
+            if (slot.used) report.threadStats.push_back(slot.stats);
+        }
+    }
+
+    // Derive totals and load-imbalance figures once all phases are recorded
+    void finalizeReport() {
+        long long maxNs = 0, sumNs = 0;
+        long long firstStart = 0, lastEnd = 0;
+        bool first = true;
+        for (const auto& stat : report.threadStats) {
+            maxNs = std::max(maxNs, stat.getDurationNs());
+            sumNs += stat.getDurationNs();
+            firstStart = first ? stat.startNs : std::min(firstStart, stat.startNs);
+            lastEnd = first ? stat.endNs : std::max(lastEnd, stat.endNs);
+            first = false;
+            report.comparisons += stat.comparisons;
+            report.moves += stat.moves;
+            report.runs += stat.runs;
+            report.mergesSkipped += stat.mergesSkipped;
+        }
+        for (const auto& level : report.mergeLevels) {
+            report.comparisons += level.comparisons;
+            report.moves += level.moves;
+            report.mergesSkipped += level.skipped;
+        }
+
+        report.sortPhaseNs = lastEnd - firstStart;
+        if (!report.threadStats.empty() && sumNs > 0) {
+            double meanNs = static_cast<double>(sumNs) / report.threadStats.size();
+            report.imbalance = maxNs / meanNs;
+            report.idleFraction = 1.0 - static_cast<double>(sumNs) / (maxNs * report.threadStats.size());
+        }
+    }
+
+public:
+    // Parallel sorting with multiple threads (AUTO_THREADS = pick from the cost model)
+    template<typename T>
+    void parallelSort(std::vector<T>& data, int numThreads = AUTO_THREADS) {
+        parallelSort(data, numThreads, std::less<T>());
+    }
+
+    // Parallel sorting ordered by a custom comparator, with the configured strategy
+    template<typename T, typename Compare>
+    void parallelSort(std::vector<T>& data, int numThreads, Compare comp) {
+        parallelSort(data, numThreads, comp, strategy);
+    }
+
+    // Parallel sorting with the given strategy for this call only
+    template<typename T, typename Compare>
+    void parallelSort(std::vector<T>& data, int numThreads, Compare comp, SortStrategy sortStrategy) {
+        report = SortReport();
+        sortStart = std::chrono::steady_clock::now();
+        long long cpuStart = cpuTimeNs(CLOCK_PROCESS_CPUTIME_ID);
+
+        if (data.size() < 2) return;  // Nothing to sort
+        ScopedTimer span("sort", "sort");
+        span.arg("records", (long long)data.size());
+
+        report.plan = planSort(data.size(), numThreads, sortStrategy);
+        numThreads = report.plan.threads;
+        cpuOfThread.clear();
+        pinFailures.store(0);
+        if (pinThreads && !report.plan.sequential) {
+            const CpuTopology& topology = CpuTopology::system();
+            cpuOfThread = topology.placement(numThreads);
+            std::vector<int> used;
+            for (int cpu : cpuOfThread) used.push_back(topology.nodeOf(cpu));
+            std::sort(used.begin(), used.end());
+            report.plan.pinned = true;
+            report.plan.numaNodes = static_cast<int>(std::unique(used.begin(), used.end()) - used.begin());
+        }
+
+        report.records = data.size();
+        report.threads = numThreads;
+        report.strategy = sortStrategy;
+        span.arg("threads", numThreads);
+
+        statSlots.assign(numThreads, ThreadStatSlot());
+
+        if (verbose) {
+            std::cout << "\n=== Starting Parallel Sort ===" << std::endl;
+            std::cout << "Total Records: " << data.size() << std::endl;
+            std::cout << "Number of Threads: " << numThreads;
+            if (report.plan.automatic) {
+                std::cout << " (auto, " << report.plan.hardwareThreads << " hardware threads)";
+            }
+            std::cout << std::endl;
+            std::cout << "Strategy: " << sortStrategyName(sortStrategy)
+                      << (report.plan.sequential ? " (sequential)" : "") << std::endl;
+            std::cout << "Records per thread (approx): " << data.size() / numThreads << std::endl;
+        }
+
+        if (report.plan.sequential) {
+            sequentialSort(data, comp);
+        } else if (sortStrategy == SortStrategy::SampleSort) {
+            sampleSort(data, numThreads, comp);
+        } else {
+            segmentSort(data, numThreads, comp);
+        }
+        report.totalWallNs = nsSinceStart();
+        report.totalCpuNs = cpuTimeNs(CLOCK_PROCESS_CPUTIME_ID) - cpuStart;
+        report.plan.pinFailures = pinFailures.load();
+        finalizeReport();
+        calibrate();
+
         printThreadStatistics();
     }
 
+    // e.g. "auto: 4 threads (8 hardware, 48.2 ns/record/level, spawn 31 us, est. 95.0 ms)"
+    static std::string describePlan(const SortPlan& plan) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1);
+        out << (plan.automatic ? "auto" : "fixed") << ": " << plan.threads
+            << (plan.sequential ? " thread (sequential)" : " threads");
+        if (plan.automatic) {
+            out << " (" << plan.hardwareThreads << " hardware, " << plan.nsPerRecordLevel
+                << " ns/record/level, spawn " << plan.spawnNs / 1000 << " us, est. " << plan.estimatedNs / 1e6 << " ms)";
+        } else if (plan.threads != plan.requestedThreads) {
+            out << " (" << plan.requestedThreads << " requested)";
+        }
+        if (plan.pinned) {
+            out << ", pinned over " << plan.numaNodes << (plan.numaNodes == 1 ? " NUMA node" : " NUMA nodes");
+            if (plan.pinFailures > 0) out << " (" << plan.pinFailures << " pin failures)";
+        }
+        return out.str();
+    }
+
     void printThreadStatistics() const {
-        std::cout << "\n=== Thread Statistics ===" << std::endl;
-        std::cout << std::left << std::setw(12) << "Thread ID" 
-                  << std::setw(15) << "Duration (ms)" 
-                  << std::setw(15) << "Records" << std::endl;
-        std::cout << std::string(42, '-') << std::endl;
+        bool natural = report.strategy != SortStrategy::MergeSort;  // Runs are counted
+        if (verbose) {
+            std::cout << "\n=== Thread Statistics ===" << std::endl;
+            std::cout << std::left << std::setw(10) << "Thread ID"
+                      << std::right << std::setw(13) << "Wall (ms)"
+                      << std::setw(13) << "CPU (ms)"
+                      << std::setw(11) << "Records"
+                      << std::setw(15) << "Comparisons"
+                      << std::setw(15) << "Moves";
+            if (natural) std::cout << std::setw(9) << "Runs" << std::setw(9) << "Skipped";
+            if (report.plan.pinned) std::cout << std::setw(6) << "Core";
+            std::cout << std::endl;
+            std::cout << std::string((natural ? 95 : 77) + (report.plan.pinned ? 6 : 0), '-') << std::endl;
 
-        for (const auto& stat : threadStats) {
-            std::cout << std::setw(12) << stat.threadId
-                      << std::setw(15) << stat.getDurationMs()
-                      << std::setw(15) << stat.recordsProcessed << std::endl;
-        }
+            std::cout << std::fixed << std::setprecision(3);
+            for (const auto& stat : report.threadStats) {
+                std::cout << std::left << std::setw(10) << stat.threadId << std::right
+                          << std::setw(13) << stat.getDurationMs()
+                          << std::setw(13) << stat.cpuNs / 1e6
+                          << std::setw(11) << stat.recordsProcessed
+                          << std::setw(15) << stat.comparisons
+                          << std::setw(15) << stat.moves;
+                if (natural) std::cout << std::setw(9) << stat.runs << std::setw(9) << stat.mergesSkipped;
+                if (report.plan.pinned) std::cout << std::setw(6) << stat.cpu;
+                std::cout << std::endl;
+            }
 
-        long long totalTime = 0;
-        for (const auto& stat : threadStats) {
-            totalTime += stat.getDurationMs();
+            if (!report.mergeLevels.empty()) {
+                std::cout << "\n=== Merge Levels (serial) ===" << std::endl;
+                std::cout << std::left << std::setw(10) << "Level"
+                          << std::right << std::setw(13) << "Run Size"
+                          << std::setw(13) << "Merges"
+                          << std::setw(13) << "Wall (ms)"
+                          << std::setw(15) << "Comparisons"
+                          << std::setw(15) << "Moves";
+                if (natural) std::cout << std::setw(9) << "Skipped";
+                std::cout << std::endl;
+                std::cout << std::string(natural ? 88 : 79, '-') << std::endl;
+                for (const auto& level : report.mergeLevels) {
+                    std::cout << std::left << std::setw(10) << level.level << std::right
+                              << std::setw(13) << level.runSize
+                              << std::setw(13) << level.merges
+                              << std::setw(13) << level.durationNs / 1e6
+                              << std::setw(15) << level.comparisons
+                              << std::setw(15) << level.moves;
+                    if (natural) std::cout << std::setw(9) << level.skipped;
+                    std::cout << std::endl;
+                }
+            }
+
+            std::cout << "\n=== Phase Breakdown ===" << std::endl;
+            std::cout << (report.strategy == SortStrategy::SampleSort ? "  Sample + bucketing:  " : "  Partition + spawn:   ")
+                      << report.partitionNs / 1e6 << " ms" << std::endl;
+            std::cout << "  Parallel sort phase: " << report.sortPhaseNs / 1e6 << " ms" << std::endl;
+            std::cout << "  Serial merge phase:  " << report.mergePhaseNs / 1e6 << " ms" << std::endl;
+            std::cout << "  Total wall time:     " << report.totalWallNs / 1e6 << " ms" << std::endl;
+            std::cout << "  Total CPU time:      " << report.totalCpuNs / 1e6 << " ms" << std::endl;
+            std::cout << "  Comparisons / moves: " << report.comparisons << " / " << report.moves << std::endl;
+            std::cout << "  Plan:                " << describePlan(report.plan) << std::endl;
+            if (natural) {
+                std::cout << "  Natural runs:        " << report.runs << " (" << report.mergesSkipped
+                          << " merges skipped, already in order)" << std::endl;
+            }
+            std::cout << std::setprecision(2);
+            std::cout << "  Load imbalance:      " << report.imbalance << "x (slowest / mean thread), "
+                      << report.idleFraction * 100 << "% idle" << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+            std::cout << std::setprecision(6);
         }
 
-        std::cout << std::string(42, '-') << std::endl;
-        std::cout << "Total Time (all threads): " << totalTime << " ms" << std::endl;
+        if (logPath.empty()) return;
 
-        // Log to file
-        std::ofstream logFile("sorting_thread_log.txt", std::ios::app);
+        // Format the log here, the file append happens on the metrics flusher thread
+        std::ostringstream logFile;
         logFile << "\n=== Sorting Log " << std::time(nullptr) << " ===" << std::endl;
-        for (const auto& stat : threadStats) {
-            logFile << "Thread " << stat.threadId << ": " << stat.getDurationMs() << " ms" << std::endl;
+        logFile << std::fixed << std::setprecision(3);
+        for (const auto& stat : report.threadStats) {
+            logFile << "Thread " << stat.threadId << ": " << stat.getDurationMs() << " ms (cpu "
+                    << stat.cpuNs / 1e6 << " ms)" << std::endl;
+        }
+        logFile << "Merge: " << report.mergePhaseNs / 1e6 << " ms over "
+                << report.mergeLevels.size() << " levels" << std::endl;
+        if (natural) {
+            logFile << "Runs: " << report.runs << " natural, " << report.mergesSkipped
+                    << " merges skipped" << std::endl;
         }
-        logFile.close();
+        logFile << "Total: " << report.totalWallNs / 1e6 << " ms wall, "
+                << report.totalCpuNs / 1e6 << " ms cpu" << std::endl;
+        logFile << "Plan: " << describePlan(report.plan) << std::endl;
+        Metrics::instance().appendText(logPath, logFile.str());
     }
 };
 
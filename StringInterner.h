@@ -0,0 +1,54 @@
+#ifndef STRING_INTERNER_H
+#define STRING_INTERNER_H
+
+#include <string>
+#include <mutex>
+#include <unordered_set>
+#include <unordered_map>
+
+// Process-wide pool of small, frequently repeated strings (branch names,
+// course codes). Each distinct value is stored once and lives until exit,
+// so records can keep a plain pointer to it. Lookups go through a
+// per-thread cache first; the shared pool is only locked the first time a
+// thread sees a value.
+class StringInterner {
+private:
+    static constexpr size_t THREAD_CACHE_LIMIT = 4096;
+
+    static std::mutex& poolMutex() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    // Node-based, so element addresses never change
+    static std::unordered_set<std::string>& pool() {
+        static std::unordered_set<std::string>* values = new std::unordered_set<std::string>(); // Never freed
+        return *values;
+    }
+
+public:
+    // Canonical copy of value
+    static const std::string* intern(const std::string& value) {
+        thread_local std::unordered_map<std::string, const std::string*> cache;
+        auto cached = cache.find(value);
+        if (cached != cache.end()) return cached->second;
+
+        const std::string* canonical;
+        {
+            std::lock_guard<std::mutex> guard(poolMutex());
+            canonical = &*pool().insert(value).first;
+        }
+        if (cache.size() < THREAD_CACHE_LIMIT) {
+            cache.emplace(value, canonical);
+        }
+        return canonical;
+    }
+
+    // Number of distinct values interned so far
+    static size_t size() {
+        std::lock_guard<std::mutex> guard(poolMutex());
+        return pool().size();
+    }
+};
+
+#endif // STRING_INTERNER_H
@@ -2,16 +2,53 @@
 #define STUDENT_H
 
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <atomic>
+#include "StringInterner.h"
+#include "SmallVector.h"
+#include "PackedRoll.h"
+
+// IIIT course code, interned: one pointer per course instead of a
+// std::string, and equal codes compare by address
+class CourseCode {
+private:
+    const std::string* value;
+
+    static const std::string* emptyCode() {
+        static const std::string* empty = StringInterner::intern("");
+        return empty;
+    }
+
+public:
+    CourseCode() : value(emptyCode()) {}
+    CourseCode(const std::string& code) : value(StringInterner::intern(code)) {}
+    CourseCode(const char* code) : value(StringInterner::intern(code)) {}
+
+    const std::string& str() const { return *value; }
+    operator const std::string&() const { return *value; }
+    size_t size() const { return value->size(); }
+    bool empty() const { return value->empty(); }
+
+    bool operator==(const CourseCode& other) const { return value == other.value; }
+    bool operator!=(const CourseCode& other) const { return value != other.value; }
+    bool operator<(const CourseCode& other) const { return value != other.value && *value < *other.value; }
+
+    friend std::ostream& operator<<(std::ostream& out, const CourseCode& code) {
+        return out << *code.value;
+    }
+};
 
 // Course structure definitions BEFORE they're used
 struct IIITCourse {
-    std::string code;
+    CourseCode code;
     int semester;
     char grade;
     
-    IIITCourse() : code(""), semester(0), grade('D') {}
+    IIITCourse() : semester(0), grade('D') {}
     IIITCourse(const std::string& c, int sem, char g) 
         : code(c), semester(sem), grade(g) {}
     
@@ -44,34 +81,124 @@ struct IITCourse {
     }
 };
 
+// Fields common to every system's view of one person (name, branch, start
+// year). A CSV row with a numeric roll becomes both an IIIT and an IIT
+// student; both point at one immutable record instead of holding copies.
+class StudentRecord {
+private:
+    mutable std::atomic<unsigned int> refs;
+
+    friend class StudentRecordRef;
+
+public:
+    const std::string name;
+    const std::string* const branch;  // Interned
+    const int startYear;
+
+    StudentRecord(const std::string& n, const std::string& b, int year)
+        : refs(0), name(n), branch(StringInterner::intern(b)), startYear(year) {}
+};
+
+// Reference-counted handle to a StudentRecord (8 bytes, thread-safe counts)
+class StudentRecordRef {
+private:
+    const StudentRecord* record;
+
+    // Shared record of default-constructed students; never freed
+    static const StudentRecord* emptyRecord() {
+        static const StudentRecord* empty = [] {
+            auto* r = new StudentRecord("", "", 0);
+            r->refs.store(1);
+            return r;
+        }();
+        return empty;
+    }
+
+    void retain() const {
+        if (record) record->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release() {
+        if (record && record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete record;
+        }
+    }
+
+    explicit StudentRecordRef(const StudentRecord* r) : record(r) { retain(); }
+
+public:
+    StudentRecordRef() : record(emptyRecord()) { retain(); }
+
+    static StudentRecordRef make(const std::string& name, const std::string& branch, int year) {
+        return StudentRecordRef(new StudentRecord(name, branch, year));
+    }
+
+    StudentRecordRef(const StudentRecordRef& other) : record(other.record) { retain(); }
+    // A moved-from handle may only be assigned to or destroyed
+    StudentRecordRef(StudentRecordRef&& other) noexcept : record(other.record) { other.record = nullptr; }
+
+    StudentRecordRef& operator=(const StudentRecordRef& other) {
+        if (record != other.record) {
+            other.retain();
+            release();
+            record = other.record;
+        }
+        return *this;
+    }
+
+    StudentRecordRef& operator=(StudentRecordRef&& other) noexcept {
+        if (this != &other) {
+            release();
+            record = other.record;
+            other.record = nullptr;
+        }
+        return *this;
+    }
+
+    ~StudentRecordRef() { release(); }
+
+    const StudentRecord& operator*() const { return *record; }
+    const StudentRecord* operator->() const { return record; }
+    const StudentRecord* get() const { return record; }
+};
+
+// Course list of a student: typical rows (up to 6 courses) are stored
+// inline, without a heap allocation
+template<typename CourseType>
+using CourseList = SmallVector<CourseType, 6>;
+
 template<typename RollType, typename CourseType>
 class Student {
 private:
     RollType rollNumber;
-    std::string name;
-    std::string branch;
-    int startYear;
-    std::vector<CourseType> coursesTaken;
+    StudentRecordRef record;
+    CourseList<CourseType> coursesTaken;
 
 public:
     // Constructor
-    Student() : rollNumber(RollType()), name(""), branch(""), startYear(0) {}
+    Student() : rollNumber(RollType()) {}
     
     Student(RollType roll, const std::string& n, const std::string& b, int year)
-        : rollNumber(roll), name(n), branch(b), startYear(year) {}
+        : rollNumber(std::move(roll)), record(StudentRecordRef::make(n, b, year)) {}
+
+    // Share the name/branch/year record of another student (e.g. the same
+    // person in the other system)
+    Student(RollType roll, StudentRecordRef shared)
+        : rollNumber(std::move(roll)), record(std::move(shared)) {}
 
     // Getters
-    RollType getRollNumber() const { return rollNumber; }
-    std::string getName() const { return name; }
-    std::string getBranch() const { return branch; }
-    int getStartYear() const { return startYear; }
-    const std::vector<CourseType>& getCourses() const { return coursesTaken; }
+    const RollType& getRollNumber() const { return rollNumber; }
+    const std::string& getName() const { return record->name; }
+    const std::string& getBranch() const { return *record->branch; }
+    int getStartYear() const { return record->startYear; }
+    const CourseList<CourseType>& getCourses() const { return coursesTaken; }
+    const StudentRecordRef& getRecord() const { return record; }
 
-    // Setters
+    // Setters (records are shared, so these give this student its own copy)
     void setRollNumber(const RollType& roll) { rollNumber = roll; }
-    void setName(const std::string& n) { name = n; }
-    void setBranch(const std::string& b) { branch = b; }
-    void setStartYear(int year) { startYear = year; }
+    void setName(const std::string& n) { record = StudentRecordRef::make(n, getBranch(), getStartYear()); }
+    void setBranch(const std::string& b) { record = StudentRecordRef::make(getName(), b, getStartYear()); }
+    void setStartYear(int year) { record = StudentRecordRef::make(getName(), getBranch(), year); }
 
     // Add course
     void addCourse(const CourseType& course) {
@@ -88,6 +215,16 @@ public:
         return false;
     }
 
+    // Average grade points over all courses (0 if no courses)
+    double getAverageGradePoints() const {
+        if (coursesTaken.empty()) return 0.0;
+        int total = 0;
+        for (const auto& course : coursesTaken) {
+            total += course.getGradePoints();
+        }
+        return static_cast<double>(total) / coursesTaken.size();
+    }
+
     // Display student info
     void display() const {
         std::cout << "Roll: ";
@@ -96,14 +233,16 @@ public:
         } else {
             std::cout << rollNumber;
         }
-        std::cout << " | Name: " << name << " | Branch: " << branch
-                  << " | Year: " << startYear << " | Courses: " << coursesTaken.size() << std::endl;
+        std::cout << " | Name: " << getName() << " | Branch: " << getBranch()
+                  << " | Year: " << getStartYear() << " | Courses: " << coursesTaken.size() << std::endl;
     }
 
     // For sorting by different criteria
     bool operator<(const Student& other) const {
-        if (startYear != other.startYear) return startYear < other.startYear;
-        return name < other.name;
+        const StudentRecord& a = *record;
+        const StudentRecord& b = *other.record;
+        if (a.startYear != b.startYear) return a.startYear < b.startYear;
+        return a.name < b.name;
     }
 
     bool operator>(const Student& other) const {
@@ -115,4 +254,76 @@ public:
     }
 };
 
+// Sort keys selectable at runtime (e.g. "year,name" on the command line)
+enum class StudentSortKey {
+    Year,
+    Name,
+    Roll,
+    Branch,
+    CourseCount
+};
+
+// Parse a comma-separated key list such as "year,name"
+// Throws invalid_argument on an unknown key
+inline std::vector<StudentSortKey> parseStudentSortKeys(const std::string& spec) {
+    std::vector<StudentSortKey> keys;
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string key = spec.substr(start, end - start);
+
+        if (key == "year") keys.push_back(StudentSortKey::Year);
+        else if (key == "name") keys.push_back(StudentSortKey::Name);
+        else if (key == "roll") keys.push_back(StudentSortKey::Roll);
+        else if (key == "branch") keys.push_back(StudentSortKey::Branch);
+        else if (key == "courses") keys.push_back(StudentSortKey::CourseCount);
+        else throw std::invalid_argument("Unknown sort key '" + key + "' (use year/name/roll/branch/courses)");
+
+        start = end + 1;
+    }
+    return keys;
+}
+
+// Lexicographic comparator over a list of sort keys
+template<typename StudentType>
+class StudentKeyCompare {
+private:
+    std::vector<StudentSortKey> keys;
+
+public:
+    explicit StudentKeyCompare(std::vector<StudentSortKey> k) : keys(std::move(k)) {}
+
+    // Whether adding a course can move a student in this order
+    bool usesCourseCount() const {
+        return std::find(keys.begin(), keys.end(), StudentSortKey::CourseCount) != keys.end();
+    }
+
+    bool operator()(const StudentType& a, const StudentType& b) const {
+        for (StudentSortKey key : keys) {
+            switch (key) {
+                case StudentSortKey::Year:
+                    if (a.getStartYear() != b.getStartYear()) return a.getStartYear() < b.getStartYear();
+                    break;
+                case StudentSortKey::Name:
+                    if (a.getName() != b.getName()) return a.getName() < b.getName();
+                    break;
+                case StudentSortKey::Roll:
+                    if (a.getRollNumber() != b.getRollNumber()) return a.getRollNumber() < b.getRollNumber();
+                    break;
+                case StudentSortKey::Branch:
+                    // Interned: equal branches share one string
+                    if (&a.getBranch() != &b.getBranch()) return a.getBranch() < b.getBranch();
+                    break;
+                case StudentSortKey::CourseCount:
+                    if (a.getCourses().size() != b.getCourses().size()) {
+                        return a.getCourses().size() < b.getCourses().size();
+                    }
+                    break;
+            }
+        }
+        return false;
+    }
+};
+
 #endif // STUDENT_H
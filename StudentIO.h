@@ -0,0 +1,552 @@
+#ifndef STUDENT_IO_H
+#define STUDENT_IO_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <charconv>
+#include "Student.h"
+#include "StudentManager.h"
+#include "CSVWriter.h"
+#include "Metrics.h"
+
+// Type aliases for IIIT-Delhi system (packed string roll numbers, string course codes)
+using IIITStudent = Student<PackedRoll, IIITCourse>;
+using IIITStudentManager = StudentManager<PackedRoll, IIITCourse>;
+
+// Type aliases for IIT-Delhi system (integer roll numbers, integer course codes)
+using IITStudent = Student<unsigned int, IITCourse>;
+using IITStudentManager = StudentManager<unsigned int, IITCourse>;
+
+// ============================================================================
+// CSV PARSING WITH ERROR HANDLING
+// ============================================================================
+
+/**
+ * Parse IIIT courses from CSV string with error handling
+ * Format: Code:Semester:Grade;Code:Semester:Grade
+ */
+template<typename CourseContainer>
+void parseIIITCourses(const std::string& coursesStr, CourseContainer& courses,
+                      std::ostream& warn = std::cerr) {
+    if (coursesStr.empty()) return;
+    
+    try {
+        std::stringstream ss(coursesStr);
+        std::string courseStr;
+        int lineCount = 0;
+        
+        while (std::getline(ss, courseStr, ';')) {
+            lineCount++;
+            if (courseStr.empty()) continue;
+            
+            try {
+                size_t pos1 = courseStr.find(':');
+                size_t pos2 = courseStr.rfind(':');
+                
+                if (pos1 == std::string::npos || pos2 == std::string::npos || pos1 == pos2) {
+                    warn << "⚠️  WARNING: Malformed course entry #" << lineCount << ": " 
+                         << courseStr << " (skipping)" << std::endl;
+                    continue;
+                }
+                
+                std::string code = courseStr.substr(0, pos1);
+                
+                if (code.empty()) {
+                    warn << "⚠️  WARNING: Empty course code in entry #" << lineCount << " (skipping)" << std::endl;
+                    continue;
+                }
+                
+                int sem = std::stoi(courseStr.substr(pos1 + 1, pos2 - pos1 - 1));
+                char grade = courseStr[pos2 + 1];
+                
+                if (grade != 'A' && grade != 'B' && grade != 'C' && grade != 'D') {
+                    warn << "⚠️  WARNING: Invalid grade '" << grade << "' in entry #" << lineCount 
+                         << " (skipping)" << std::endl;
+                    continue;
+                }
+                
+                courses.push_back(IIITCourse(code, sem, grade));
+            } catch (const std::invalid_argument& e) {
+                warn << "⚠️  WARNING: Invalid course data in entry #" << lineCount 
+                     << " - " << e.what() << " (skipping)" << std::endl;
+                continue;
+            } catch (const std::exception& e) {
+                warn << "⚠️  WARNING: Error parsing course entry #" << lineCount 
+                     << " - " << e.what() << " (skipping)" << std::endl;
+                continue;
+            }
+        }
+    } catch (const std::exception& e) {
+        warn << "⚠️  WARNING: Error parsing IIIT courses: " << e.what() << std::endl;
+    }
+}
+
+/**
+ * Parse IIT courses from CSV string with error handling
+ * Format: Code:Grade;Code:Grade
+ */
+template<typename CourseContainer>
+void parseIITCourses(const std::string& coursesStr, CourseContainer& courses,
+                     std::ostream& warn = std::cerr) {
+    if (coursesStr.empty()) return;
+    
+    try {
+        std::stringstream ss(coursesStr);
+        std::string courseStr;
+        int lineCount = 0;
+        
+        while (std::getline(ss, courseStr, ';')) {
+            lineCount++;
+            if (courseStr.empty()) continue;
+            
+            try {
+                size_t pos = courseStr.find(':');
+                
+                if (pos == std::string::npos) {
+                    warn << "⚠️  WARNING: Malformed IIT course entry #" << lineCount 
+                         << ": " << courseStr << " (skipping)" << std::endl;
+                    continue;
+                }
+                
+                int code = std::stoi(courseStr.substr(0, pos));
+                char grade = courseStr[pos + 1];
+                
+                if (grade != 'A' && grade != 'B' && grade != 'C' && grade != 'D') {
+                    warn << "⚠️  WARNING: Invalid grade '" << grade << "' in IIT entry #" << lineCount 
+                         << " (skipping)" << std::endl;
+                    continue;
+                }
+                
+                courses.push_back(IITCourse(code, grade));
+            } catch (const std::invalid_argument& e) {
+                warn << "⚠️  WARNING: Invalid IIT course data in entry #" << lineCount 
+                     << " - " << e.what() << " (skipping)" << std::endl;
+                continue;
+            } catch (const std::exception& e) {
+                warn << "⚠️  WARNING: Error parsing IIT course entry #" << lineCount 
+                     << " - " << e.what() << " (skipping)" << std::endl;
+                continue;
+            }
+        }
+    } catch (const std::exception& e) {
+        warn << "⚠️  WARNING: Error parsing IIT courses: " << e.what() << std::endl;
+    }
+}
+
+// ============================================================================
+// ROLL / YEAR CLASSIFICATION (no exceptions on the per-row path)
+// ============================================================================
+
+enum class RollKind {
+    Numeric,      // Decimal digits only, fits unsigned int: also an IIT student
+    NonNumeric,   // e.g. MT23646 or 12AB: IIIT only
+    OutOfRange    // Digits only, but too large for an IIT roll number
+};
+
+/**
+ * Decide whether a roll number also belongs to the IIT system
+ * The whole string must be digits (no sign, spaces or suffix); value is set
+ * for Numeric rolls only
+ */
+inline RollKind classifyRoll(const std::string& roll, unsigned int& value) {
+    if (roll.empty() || roll[0] < '0' || roll[0] > '9') return RollKind::NonNumeric;
+    const char* end = roll.data() + roll.size();
+    auto result = std::from_chars(roll.data(), end, value);
+    // On overflow ptr still skips every digit, so a suffix is always detected
+    if (result.ptr != end) return RollKind::NonNumeric;
+    return result.ec == std::errc() ? RollKind::Numeric : RollKind::OutOfRange;
+}
+
+/**
+ * Parse a start year (surrounding blanks allowed, nothing else)
+ * Returns false for non-numeric text or years outside 1900-2100
+ */
+inline bool parseStartYear(const std::string& text, int& year) {
+    size_t first = text.find_first_not_of(" \t");
+    size_t last = text.find_last_not_of(" \t");
+    if (first == std::string::npos) return false;
+    const char* begin = text.data() + first;
+    const char* end = text.data() + last + 1;
+    auto result = std::from_chars(begin, end, year);
+    return result.ec == std::errc() && result.ptr == end && year >= 1900 && year <= 2100;
+}
+
+// ============================================================================
+// FILE LOADING WITH ERROR HANDLING
+// ============================================================================
+
+/**
+ * Outcome of one data row: accepted rows count as loaded, errors are
+ * counted separately (a row can be accepted and still report an error)
+ */
+struct RowOutcome {
+    bool accepted = false;
+    int errors = 0;
+};
+
+/**
+ * Parse one CSV data row and hand the resulting students to the sinks
+ * addIIIT(IIITStudent&&) gets every valid row, addIIT(IITStudent&&) only
+ * rows with numeric rolls; warnings go to `warn`
+ */
+template<typename IIITSink, typename IITSink>
+RowOutcome parseStudentRow(const std::string& line, int lineNumber, IIITSink&& addIIIT, IITSink&& addIIT,
+                           std::ostream& warn = std::cerr) {
+    RowOutcome outcome;
+    
+    try {
+        if (line.empty()) return outcome;
+        
+        // Tolerate CRLF files
+        size_t length = line.size();
+        if (line[length - 1] == '\r') {
+            length--;
+            if (length == 0) return outcome;
+        }
+        
+        std::stringstream ss(line.substr(0, length));
+        std::string rollStr, name, branch, yearStr, iiitCoursesStr, iitCoursesStr;
+        
+        if (!std::getline(ss, rollStr, ',')) {
+            throw std::runtime_error("Missing roll number");
+        }
+        
+        if (!std::getline(ss, name, ',')) {
+            throw std::runtime_error("Missing name");
+        }
+        
+        if (!std::getline(ss, branch, ',')) {
+            throw std::runtime_error("Missing branch");
+        }
+        
+        if (!std::getline(ss, yearStr, ',')) {
+            throw std::runtime_error("Missing start year");
+        }
+        
+        if (!std::getline(ss, iiitCoursesStr, ',')) {
+            iiitCoursesStr = "";
+        }
+        
+        if (!std::getline(ss, iitCoursesStr, ',')) {
+            iitCoursesStr = "";
+        }
+        
+        if (rollStr.empty() || name.empty()) {
+            warn << "⚠️  WARNING: Line " << lineNumber << " - Empty roll or name (skipping)" << std::endl;
+            outcome.errors++;
+            return outcome;
+        }
+        
+        int year;
+        if (!parseStartYear(yearStr, year)) {
+            warn << "⚠️  WARNING: Line " << lineNumber << " - Invalid year '" << yearStr 
+                 << "' (skipping)" << std::endl;
+            outcome.errors++;
+            return outcome;
+        }
+        
+        // One name/branch/year record, shared by both systems' students
+        StudentRecordRef record = StudentRecordRef::make(name, branch, year);
+        
+        // Add to IIIT system
+        try {
+            IIITStudent iiitStudent(PackedRoll(rollStr), record);
+            CourseList<IIITCourse> iiitCourses;
+            parseIIITCourses(iiitCoursesStr, iiitCourses, warn);
+            
+            for (const auto& course : iiitCourses) {
+                iiitStudent.addCourse(course);
+            }
+            
+            addIIIT(std::move(iiitStudent));
+        } catch (const std::exception& e) {
+            warn << "⚠️  WARNING: Line " << lineNumber << " - Failed to add IIIT student: " 
+                 << e.what() << std::endl;
+            outcome.errors++;
+        }
+        
+        // Add to IIT system (only if roll number is numeric)
+        unsigned int rollNum = 0;
+        RollKind rollKind = classifyRoll(rollStr, rollNum);
+        if (rollKind == RollKind::OutOfRange) {
+            warn << "⚠️  WARNING: Line " << lineNumber << " - Roll number " << rollStr
+                 << " too large for the IIT system (IIIT only)" << std::endl;
+        } else if (rollKind == RollKind::Numeric) {
+            try {
+                IITStudent iitStudent(rollNum, std::move(record));
+                CourseList<IITCourse> iitCourses;
+                parseIITCourses(iitCoursesStr, iitCourses, warn);
+                
+                for (const auto& course : iitCourses) {
+                    iitStudent.addCourse(course);
+                }
+                
+                addIIT(std::move(iitStudent));
+            } catch (const std::exception& e) {
+                warn << "⚠️  WARNING: Line " << lineNumber << " - Failed to add IIT student: " 
+                     << e.what() << std::endl;
+            }
+        }
+        
+        outcome.accepted = true;
+    } catch (const std::exception& e) {
+        warn << "⚠️  WARNING: Line " << lineNumber << " - " << e.what() << " (skipping)" << std::endl;
+        outcome.errors++;
+    }
+    
+    return outcome;
+}
+
+/**
+ * Result of loading one CSV file
+ */
+struct LoadResult {
+    int successCount = 0;
+    int errorCount = 0;
+    bool presortedApplied = false;
+};
+
+/**
+ * Load students from CSV text into both managers without prompting
+ * Every row goes to the IIIT manager; rows with numeric rolls also go to IIT
+ * @param presorted: input is a sorted export - rebuild sorted view without sorting
+ * @param maxRows: stop after this many students (0 = no limit)
+ * Throws runtime_error if the header cannot be read
+ */
+inline LoadResult loadStudentsFromStream(std::istream& file, IIITStudentManager& iiitManager,
+                                         IITStudentManager& iitManager, bool presorted, int maxRows) {
+    ScopedTimer span("load.csv", "load");
+    LoadResult result;
+    int& successCount = result.successCount;
+    int& errorCount = result.errorCount;
+    
+    size_t iiitBefore = iiitManager.getTotalStudents();
+    size_t iitBefore = iitManager.getTotalStudents();
+    
+    std::string line;
+    
+    if (!std::getline(file, line)) {
+        throw std::runtime_error("File is empty or cannot be read");
+    }
+    
+    int lineNumber = 1;
+    
+    while (std::getline(file, line) && (maxRows <= 0 || successCount < maxRows)) {
+        lineNumber++;
+        
+        RowOutcome outcome = parseStudentRow(line, lineNumber,
+            [&](IIITStudent&& student) { iiitManager.addStudent(std::move(student)); },
+            [&](IITStudent&& student) { iitManager.addStudent(std::move(student)); });
+        if (outcome.accepted) successCount++;
+        errorCount += outcome.errors;
+    }
+    
+    span.arg("rows", successCount);
+    span.arg("rejected", errorCount);
+    Metrics::instance().recordCounter("load.rows_rejected", "load", errorCount);
+
+    // Presorted only holds when the file is the whole data set
+    if (presorted) {
+        ScopedTimer presortSpan("load.presorted_check", "load");
+        if (iiitBefore == 0 && iitBefore == 0 &&
+            iiitManager.markPresorted() && iitManager.markPresorted()) {
+            result.presortedApplied = true;
+        } else {
+            iiitManager.sortStudents();
+            iitManager.sortStudents();
+        }
+    }
+    
+    return result;
+}
+
+/**
+ * Load students from CSV file with comprehensive error handling
+ * Handles missing files, corrupted data, format errors
+ */
+
+/**
+ * Load students from a CSV file into both managers without prompting
+ * Throws runtime_error if the file cannot be opened or read
+ */
+inline LoadResult loadStudentsFromFile(const std::string& filename, IIITStudentManager& iiitManager,
+                                       IITStudentManager& iitManager, bool presorted, int maxRows) {
+    std::ifstream file(filename);
+    
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+    
+    return loadStudentsFromStream(file, iiitManager, iitManager, presorted, maxRows);
+}
+
+// ============================================================================
+// CSV EXPORT
+// ============================================================================
+
+/**
+ * Append the entries of one course column in the format
+ * loadStudentsFromCSV reads: IIIT courses as Code:Sem:Grade,
+ * IIT courses as Code:Grade, entries separated by ';'
+ */
+inline void appendCourseEntries(std::string& out, const CourseList<IIITCourse>& courses) {
+    for (size_t i = 0; i < courses.size(); i++) {
+        if (i > 0) out.push_back(';');
+        appendCSVField(out, courses[i].code);
+        out.push_back(':');
+        appendCSVField(out, courses[i].semester);
+        out.push_back(':');
+        appendCSVField(out, courses[i].grade);
+    }
+}
+
+inline void appendCourseEntries(std::string& out, const CourseList<IITCourse>& courses) {
+    for (size_t i = 0; i < courses.size(); i++) {
+        if (i > 0) out.push_back(';');
+        appendCSVField(out, courses[i].code);
+        out.push_back(':');
+        appendCSVField(out, courses[i].grade);
+    }
+}
+
+/**
+ * Append both course columns: IIIT courses in column 5, IIT courses in
+ * column 6. A missing list (nullptr) leaves its column empty
+ */
+inline void appendCourseColumns(std::string& out, const CourseList<IIITCourse>* iiitCourses,
+                                const CourseList<IITCourse>* iitCourses) {
+    if (iiitCourses) appendCourseEntries(out, *iiitCourses);
+    out.push_back(',');
+    if (iitCourses) appendCourseEntries(out, *iitCourses);
+}
+
+// A student's own column, plus the other system's courses of the same person if known
+inline void appendCourseColumns(std::string& out, const CourseList<IIITCourse>& courses,
+                                const CourseList<IITCourse>* twinCourses = nullptr) {
+    appendCourseColumns(out, &courses, twinCourses);
+}
+
+inline void appendCourseColumns(std::string& out, const CourseList<IITCourse>& courses,
+                                const CourseList<IIITCourse>* twinCourses = nullptr) {
+    appendCourseColumns(out, twinCourses, &courses);
+}
+
+// Header line of students.csv and of every export
+inline const char* studentCSVHeader() {
+    return "RollNumber,Name,Branch,StartYear,IIITCourses(Code:Sem:Grade),IITCourses(Code:Grade)";
+}
+
+/**
+ * Append one student as a CSV row in the input format, including the newline
+ * Only the student's own course column is filled
+ */
+template<typename RollType, typename CourseType>
+void appendStudentRow(std::string& out, const Student<RollType, CourseType>& student) {
+    // Write basic info
+    appendCSVField(out, student.getRollNumber());
+    out.push_back(',');
+    appendCSVField(out, student.getName());
+    out.push_back(',');
+    appendCSVField(out, student.getBranch());
+    out.push_back(',');
+    appendCSVField(out, student.getStartYear());
+    out.push_back(',');
+    
+    // Write full course lists
+    appendCourseColumns(out, student.getCourses());
+    out.push_back('\n');
+}
+
+/**
+ * Append one person as a CSV row: the student plus, if twin is set, the
+ * other system's student loaded from the same row. Both course columns are
+ * written, so the row loads back into both systems. An IIT student with an
+ * IIIT twin takes the twin's roll text (which keeps e.g. leading zeros)
+ */
+template<typename RollType, typename CourseType, typename TwinRoll, typename TwinCourse>
+void appendStudentRow(std::string& out, const Student<RollType, CourseType>& student,
+                      const Student<TwinRoll, TwinCourse>* twin) {
+    if (twin && std::is_same<TwinRoll, PackedRoll>::value) {
+        appendCSVField(out, twin->getRollNumber());
+    } else {
+        appendCSVField(out, student.getRollNumber());
+    }
+    out.push_back(',');
+    appendCSVField(out, student.getName());
+    out.push_back(',');
+    appendCSVField(out, student.getBranch());
+    out.push_back(',');
+    appendCSVField(out, student.getStartYear());
+    out.push_back(',');
+    appendCourseColumns(out, student.getCourses(), twin ? &twin->getCourses() : nullptr);
+    out.push_back('\n');
+}
+
+/**
+ * Pairs students of one manager with their entries in the other system.
+ * parseStudentRow (and the snapshot loader) give the IIIT and IIT students
+ * of one row the same name/branch/year record, so the record address
+ * identifies the person. A sorted array keeps this at 16 bytes per student
+ * and safe for the parallel export workers to read
+ */
+template<typename RollType, typename CourseType>
+class TwinLookup {
+private:
+    const std::vector<Student<RollType, CourseType>>& students;
+    std::vector<std::pair<const StudentRecord*, int>> byRecord;  // First student per record
+
+public:
+    explicit TwinLookup(const StudentManager<RollType, CourseType>& manager)
+        : students(manager.getStudents()) {
+        byRecord.reserve(students.size());
+        for (size_t i = 0; i < students.size(); i++) {
+            byRecord.push_back({students[i].getRecord().get(), static_cast<int>(i)});
+        }
+        std::sort(byRecord.begin(), byRecord.end());
+    }
+
+    // The student sharing record, or nullptr
+    const Student<RollType, CourseType>* find(const StudentRecordRef& record) const {
+        auto it = std::lower_bound(byRecord.begin(), byRecord.end(),
+            std::pair<const StudentRecord*, int>(record.get(), -1));
+        if (it == byRecord.end() || it->first != record.get()) return nullptr;
+        return &students[it->second];
+    }
+};
+
+/**
+ * Write the sorted view of a manager to CSV without any console output
+ * Rows are formatted into large buffers in parallel (ParallelCSVWriter)
+ * and written in order, so export cost is I/O rather than per-row flushes.
+ * The output uses the input format, so it can be loaded back as presorted.
+ * twins is the other system's manager: each row also carries that system's
+ * courses of the same person, so reloading an export restores both systems
+ * for everyone in it (the IIT export holds numeric rolls only)
+ * @return Number of students written; throws runtime_error on I/O failure
+ */
+template<typename RollType, typename CourseType, typename TwinRoll, typename TwinCourse>
+size_t exportSortedCSV(StudentManager<RollType, CourseType>& manager,
+                       const StudentManager<TwinRoll, TwinCourse>& twins, const std::string& filename) {
+    // Get students in sorted order (sorts only if not already sorted)
+    const auto& order = manager.getSortedOrderIndices();
+    const auto& students = std::as_const(manager).getStudents();
+    TwinLookup<TwinRoll, TwinCourse> lookup(twins);
+    
+    ParallelCSVWriter writer;
+    writer.write(filename, studentCSVHeader(), order.size(),
+        [&](std::string& out, size_t row) {
+            const auto& student = students[order[row]];
+            appendStudentRow(out, student, lookup.find(student.getRecord()));
+        });
+    
+    return order.size();
+}
+
+#endif // STUDENT_IO_H
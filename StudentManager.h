@@ -3,9 +3,17 @@
 
 #include "Student.h"
 #include "Iterator.h"
+#include "Aggregation.h"
+#include "SemesterIndex.h"
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <string>
+#include <utility>
+#include <type_traits>
 
 // Template class to manage collection of students
 template<typename RollType, typename CourseType>
@@ -15,26 +23,328 @@ private:
     std::vector<int> insertionOrder; // Indices in insertion order
     std::vector<int> sortedOrder;    // Indices in sorted order
     bool isSorted;
+    bool sortUsesCourses;            // sortedOrder depends on course counts (sort --key courses)
+    bool sortUsesDefaultKey;         // sortedOrder follows Student::operator<
+    unsigned long long courseVersion; // Bumped by addCourse
+    std::unordered_map<RollType, int> rollIndex; // Roll -> first storage index
+    bool rollIndexValid;
+
+    // Ordered secondary indexes (buildOrderedIndexes). Each order lists
+    // storage indices by key, ties in storage order
+    std::vector<int> yearOrder;
+    std::vector<std::pair<int, size_t>> yearBuckets; // (year, first position in yearOrder), ascending
+    std::vector<int> nameOrder;
+    std::vector<int> rollOrder;                      // Text rolls only
+    bool orderedIndexesValid;
+
+    // (student, semester) -> SGPA/CGPA (buildSemesterIndex), IIIT courses only
+    SemesterIndex<CourseType> semesterIndex;
+    bool semesterIndexValid;
+
+    static constexpr bool hasTextRolls =
+        std::is_same<RollType, std::string>::value || std::is_same<RollType, PackedRoll>::value;
+
+    void indexLastRoll() {
+        if (rollIndexValid) {
+            rollIndex.emplace(students.back().getRollNumber(), static_cast<int>(students.size() - 1));
+        }
+        if (semesterIndexValid) {
+            semesterIndex.addStudent(static_cast<int>(students.size() - 1), students.back());
+        }
+    }
+
+    // Positions [first, last) of yearOrder with from <= year <= to
+    std::pair<size_t, size_t> yearBounds(int from, int to) const {
+        if (from > to) return {0, 0};
+        auto byYear = [](const std::pair<int, size_t>& bucket, int year) { return bucket.first < year; };
+        auto lo = std::lower_bound(yearBuckets.begin(), yearBuckets.end(), from, byYear);
+        auto hi = std::lower_bound(lo, yearBuckets.end(), to + 1LL,
+            [](const std::pair<int, size_t>& bucket, long long year) { return bucket.first < year; });
+        size_t first = lo == yearBuckets.end() ? yearOrder.size() : lo->second;
+        size_t last = hi == yearBuckets.end() ? yearOrder.size() : hi->second;
+        return {first, last};
+    }
+
+    // Positions [first, last) of an order sorted by key(student) whose key starts with prefix
+    template<typename Key>
+    std::pair<size_t, size_t> prefixBounds(const std::vector<int>& order, const std::string& prefix, Key key) const {
+        auto first = std::partition_point(order.begin(), order.end(), [&](int i) {
+            return key(students[i]).compare(0, prefix.size(), prefix) < 0;
+        });
+        auto last = std::partition_point(first, order.end(), [&](int i) {
+            return key(students[i]).compare(0, prefix.size(), prefix) == 0;
+        });
+        return {static_cast<size_t>(first - order.begin()), static_cast<size_t>(last - order.begin())};
+    }
+
+    // Without an index: scan, then order the matches as the index would
+    template<typename Match, typename Less>
+    std::vector<int> scanInIndexOrder(Match match, Less less) const {
+        std::vector<int> results;
+        for (size_t i = 0; i < students.size(); i++) {
+            if (match(students[i])) results.push_back(static_cast<int>(i));
+        }
+        std::stable_sort(results.begin(), results.end(),
+            [&](int a, int b) { return less(students[a], students[b]); });
+        return results;
+    }
+
+    static const std::string& nameKey(const Student<RollType, CourseType>& student) {
+        return student.getName();
+    }
+
+    static const RollType& rollKey(const Student<RollType, CourseType>& student) {
+        return student.getRollNumber();
+    }
+
+    // Students may be about to change: drop everything keyed on their fields
+    void invalidateLookupIndexes() {
+        rollIndexValid = false;
+        rollIndex.clear();
+        orderedIndexesValid = false;
+        semesterIndexValid = false;
+        semesterIndex.clear();
+    }
+
+    SortedOrderRange<const Student<RollType, CourseType>> orderRange(const std::vector<int>& order,
+                                                                    std::pair<size_t, size_t> bounds) const {
+        return SortedOrderRange<const Student<RollType, CourseType>>(&students, &order, bounds.first, bounds.second);
+    }
+
+    // Whether an order by comp can change when a student gains a course;
+    // unknown comparators are assumed to look at courses
+    template<typename Compare>
+    static bool comparesCourses(const Compare&) { return true; }
+    static bool comparesCourses(const std::less<Student<RollType, CourseType>>&) { return false; }
+    static bool comparesCourses(const StudentKeyCompare<Student<RollType, CourseType>>& comp) {
+        return comp.usesCourseCount();
+    }
+
+    // Whether an order by comp is the operator< order
+    template<typename Compare>
+    static bool isDefaultKey(const Compare&) { return false; }
+    static bool isDefaultKey(const std::less<Student<RollType, CourseType>>&) { return true; }
 
 public:
-    StudentManager() : isSorted(false) {}
+    StudentManager() : isSorted(false), sortUsesCourses(false), sortUsesDefaultKey(false), courseVersion(0),
+                       rollIndexValid(false),
+                       orderedIndexesValid(false), semesterIndexValid(false) {}
 
     // Add student to manager
     void addStudent(const Student<RollType, CourseType>& student) {
         students.push_back(student);
         insertionOrder.push_back(students.size() - 1);
         isSorted = false;
+        orderedIndexesValid = false;
+        indexLastRoll();
     }
 
-    // Get student by index
-    Student<RollType, CourseType>& getStudent(int index) {
-        return students[index];
+    void addStudent(Student<RollType, CourseType>&& student) {
+        students.push_back(std::move(student));
+        insertionOrder.push_back(students.size() - 1);
+        isSorted = false;
+        orderedIndexesValid = false;
+        indexLastRoll();
+    }
+
+    // Build the roll number -> index map used by findByRoll. It stays valid
+    // across addStudent, and is dropped when storage is handed out mutably
+    // (getStudents()), since callers such as parallelSort move students around.
+    void buildRollIndex() {
+        rollIndex.clear();
+        rollIndex.reserve(students.size());
+        for (size_t i = 0; i < students.size(); i++) {
+            rollIndex.emplace(students[i].getRollNumber(), static_cast<int>(i));
+        }
+        rollIndexValid = true;
     }
 
+    bool hasRollIndex() const {
+        return rollIndexValid;
+    }
+
+    // Build the per-semester SGPA/CGPA index. Like the roll index it is kept
+    // current by addStudent and addCourse, and dropped by mutable
+    // getStudents(). Throws invalid_argument for courses without semesters.
+    void buildSemesterIndex() {
+        semesterIndex.buildIndex(students);
+        semesterIndexValid = true;
+    }
+
+    bool hasSemesterIndex() const {
+        return semesterIndexValid;
+    }
+
+    // Read-only access; throws runtime_error if the index has not been built
+    const SemesterIndex<CourseType>& getSemesterIndex() const {
+        if (!semesterIndexValid) {
+            throw std::runtime_error("Semester index not built");
+        }
+        return semesterIndex;
+    }
+
+    // Record one more course for the student at storage index, updating the
+    // semester index. Course lists do not affect the name/year/roll indexes
+    // or the default sort order; a sorted order that compares course counts
+    // is dropped. Course indexes kept outside the manager (SearchIndex)
+    // compare getCourseVersion() to notice the change.
+    void addCourse(int index, const CourseType& course) {
+        students.at(index).addCourse(course);
+        courseVersion++;
+        if (sortUsesCourses) isSorted = false;
+        if (semesterIndexValid) semesterIndex.addCourse(index, course);
+    }
+
+    // Number of addCourse calls so far
+    unsigned long long getCourseVersion() const {
+        return courseVersion;
+    }
+
+    // Students whose SGPA fell by more than minDrop between consecutive
+    // semesters (builds the semester index if needed)
+    std::vector<SGPADrop> findSGPADrops(double minDrop) {
+        if (!semesterIndexValid) buildSemesterIndex();
+        return semesterIndex.findSGPADrops(minDrop);
+    }
+
+    // The k best SGPAs of a semester (builds the semester index if needed)
+    std::vector<SemesterRank> findTopSGPA(int semester, size_t k) {
+        if (!semesterIndexValid) buildSemesterIndex();
+        return semesterIndex.topSGPA(semester, k);
+    }
+
+    // Build the year bucket array, the name order and (for string rolls) the
+    // roll order. They answer range and prefix queries in O(log n + k) and
+    // are dropped by addStudent and by mutable getStudents(); the range
+    // accessors rebuild them on demand, the find* queries scan until then.
+    void buildOrderedIndexes() {
+        std::vector<int> identity(students.size());
+        for (size_t i = 0; i < students.size(); i++) {
+            identity[i] = static_cast<int>(i);
+        }
+
+        yearOrder = identity;
+        std::stable_sort(yearOrder.begin(), yearOrder.end(), [this](int a, int b) {
+            return students[a].getStartYear() < students[b].getStartYear();
+        });
+        yearBuckets.clear();
+        for (size_t pos = 0; pos < yearOrder.size(); pos++) {
+            int year = students[yearOrder[pos]].getStartYear();
+            if (yearBuckets.empty() || yearBuckets.back().first != year) {
+                yearBuckets.push_back({year, pos});
+            }
+        }
+
+        nameOrder = identity;
+        std::stable_sort(nameOrder.begin(), nameOrder.end(), [this](int a, int b) {
+            return students[a].getName() < students[b].getName();
+        });
+
+        rollOrder.clear();
+        if constexpr (hasTextRolls) {
+            rollOrder = std::move(identity);
+            std::stable_sort(rollOrder.begin(), rollOrder.end(), [this](int a, int b) {
+                return students[a].getRollNumber() < students[b].getRollNumber();
+            });
+        }
+        orderedIndexesValid = true;
+    }
+
+    bool hasOrderedIndexes() const {
+        return orderedIndexesValid;
+    }
+
+    // Storage indices of students with from <= startYear <= to, by year then
+    // storage order; safe for concurrent readers
+    std::vector<int> findByYearRange(int from, int to) const {
+        if (!orderedIndexesValid) {
+            return scanInIndexOrder(
+                [&](const Student<RollType, CourseType>& s) {
+                    return s.getStartYear() >= from && s.getStartYear() <= to;
+                },
+                [](const Student<RollType, CourseType>& a, const Student<RollType, CourseType>& b) {
+                    return a.getStartYear() < b.getStartYear();
+                });
+        }
+        auto bounds = yearBounds(from, to);
+        return std::vector<int>(yearOrder.begin() + bounds.first, yearOrder.begin() + bounds.second);
+    }
+
+    // Storage indices of students whose name starts with prefix, by name
+    std::vector<int> findByNamePrefix(const std::string& prefix) const {
+        if (!orderedIndexesValid) {
+            return scanInIndexOrder(
+                [&](const Student<RollType, CourseType>& s) {
+                    return s.getName().compare(0, prefix.size(), prefix) == 0;
+                },
+                [](const Student<RollType, CourseType>& a, const Student<RollType, CourseType>& b) {
+                    return a.getName() < b.getName();
+                });
+        }
+        auto bounds = prefixBounds(nameOrder, prefix, nameKey);
+        return std::vector<int>(nameOrder.begin() + bounds.first, nameOrder.begin() + bounds.second);
+    }
+
+    // Storage indices of students whose roll number starts with prefix, by
+    // roll (text roll numbers only)
+    std::vector<int> findByRollPrefix(const std::string& prefix) const {
+        static_assert(hasTextRolls, "Roll prefix search needs text roll numbers");
+        if (!orderedIndexesValid) {
+            return scanInIndexOrder(
+                [&](const Student<RollType, CourseType>& s) {
+                    return s.getRollNumber().compare(0, prefix.size(), prefix) == 0;
+                },
+                [](const Student<RollType, CourseType>& a, const Student<RollType, CourseType>& b) {
+                    return a.getRollNumber() < b.getRollNumber();
+                });
+        }
+        auto bounds = prefixBounds(rollOrder, prefix, rollKey);
+        return std::vector<int>(rollOrder.begin() + bounds.first, rollOrder.begin() + bounds.second);
+    }
+
+    // Read-only iterator ranges over the same results (build the indexes if
+    // needed). They walk the index orders, which writes would invalidate
+    SortedOrderRange<const Student<RollType, CourseType>> getYearRange(int from, int to) {
+        if (!orderedIndexesValid) buildOrderedIndexes();
+        return orderRange(yearOrder, yearBounds(from, to));
+    }
+
+    SortedOrderRange<const Student<RollType, CourseType>> getNamePrefixRange(const std::string& prefix) {
+        if (!orderedIndexesValid) buildOrderedIndexes();
+        return orderRange(nameOrder, prefixBounds(nameOrder, prefix, nameKey));
+    }
+
+    SortedOrderRange<const Student<RollType, CourseType>> getRollPrefixRange(const std::string& prefix) {
+        static_assert(hasTextRolls, "Roll prefix search needs text roll numbers");
+        if (!orderedIndexesValid) buildOrderedIndexes();
+        return orderRange(rollOrder, prefixBounds(rollOrder, prefix, rollKey));
+    }
+
+    // Storage index of the first student with this roll number, or -1
+    // O(1) with a roll index, O(n) scan otherwise; safe for concurrent readers
+    int findByRoll(const RollType& roll) const {
+        if (rollIndexValid) {
+            auto it = rollIndex.find(roll);
+            return it == rollIndex.end() ? -1 : it->second;
+        }
+        for (size_t i = 0; i < students.size(); i++) {
+            if (students[i].getRollNumber() == roll) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // Get student by index (read-only: use addCourse, or getStudents() for
+    // other writes, so the lookup indexes stay in step)
     const Student<RollType, CourseType>& getStudent(int index) const {
         return students[index];
     }
 
+    // Reserve storage ahead of a bulk load
+    void reserve(size_t count) {
+        students.reserve(count);
+        insertionOrder.reserve(count);
+    }
+
     // Get total number of students
     size_t getTotalStudents() const {
         return students.size();
@@ -48,16 +358,131 @@ public:
                 return students[a] < students[b];
             });
         isSorted = true;
+        sortUsesCourses = false;
+        sortUsesDefaultKey = true;
     }
 
-    // Get insertion order iterator
+    // Mark the current storage order as already sorted (e.g. loaded from a
+    // sorted export, or physically sorted by parallelSort). sortedOrder is
+    // rebuilt as the identity permutation after an O(n) check; returns false
+    // and falls back to a full sort if the data turns out to be unsorted.
+    bool markPresorted() {
+        sortedOrder = insertionOrder;
+        bool inOrder = std::is_sorted(sortedOrder.begin(), sortedOrder.end(),
+            [this](int a, int b) {
+                return students[a] < students[b];
+            });
+        if (!inOrder) {
+            sortStudents();
+            return false;
+        }
+        isSorted = true;
+        sortUsesCourses = false;
+        sortUsesDefaultKey = true;
+        return true;
+    }
+
+    // Same, for storage sorted by a custom comparator (e.g. StudentKeyCompare)
+    template<typename Compare>
+    bool markPresorted(Compare comp) {
+        sortedOrder = insertionOrder;
+        bool inOrder = std::is_sorted(sortedOrder.begin(), sortedOrder.end(),
+            [this, &comp](int a, int b) {
+                return comp(students[a], students[b]);
+            });
+        if (!inOrder) {
+            std::sort(sortedOrder.begin(), sortedOrder.end(),
+                [this, &comp](int a, int b) {
+                    return comp(students[a], students[b]);
+                });
+        }
+        isSorted = true;
+        sortUsesCourses = comparesCourses(comp);
+        sortUsesDefaultKey = isDefaultKey(comp);
+        return inOrder;
+    }
+
+    // Restore a previously computed sorted order (e.g. from a snapshot)
+    // Throws invalid_argument unless order lists every storage index once
+    void restoreSortedOrder(std::vector<int> order) {
+        if (order.size() != students.size()) {
+            throw std::invalid_argument("Sorted order does not match student count");
+        }
+        std::vector<char> seen(students.size(), 0);
+        for (int idx : order) {
+            if (idx < 0 || static_cast<size_t>(idx) >= students.size()) {
+                throw std::invalid_argument("Sorted order index out of range");
+            }
+            if (seen[idx]) {
+                throw std::invalid_argument("Sorted order repeats student " + std::to_string(idx));
+            }
+            seen[idx] = 1;
+        }
+        sortedOrder = std::move(order);
+        isSorted = true;
+        sortUsesCourses = true;  // The key is not recorded, so assume courses
+        sortUsesDefaultKey = false;
+    }
+
+    // Same, for an order known to be sorted by comp
+    template<typename Compare>
+    void restoreSortedOrder(std::vector<int> order, Compare comp) {
+        restoreSortedOrder(std::move(order));
+        sortUsesCourses = comparesCourses(comp);
+        sortUsesDefaultKey = isDefaultKey(comp);
+    }
+
+    // Whether the sorted view is currently valid
+    bool hasSortedOrder() const {
+        return isSorted;
+    }
+
+    // Whether the sorted view is valid and ordered by operator< (not by a
+    // custom key, and not restored from a snapshot with an unknown key)
+    bool hasDefaultSortedOrder() const {
+        return isSorted && sortUsesDefaultKey;
+    }
+
+    // begin()/end() views for std algorithms and range-based for loops. The
+    // mutable views hand out writable students, so like getStudents() they
+    // drop the roll and ordered indexes; the sorted one sorts if needed
+    InsertionOrderRange<Student<RollType, CourseType>> getInsertionOrderView() {
+        invalidateLookupIndexes();
+        return InsertionOrderRange<Student<RollType, CourseType>>(&students, &insertionOrder);
+    }
+
+    InsertionOrderRange<const Student<RollType, CourseType>> getInsertionOrderView() const {
+        return InsertionOrderRange<const Student<RollType, CourseType>>(&students, &insertionOrder);
+    }
+
+    SortedOrderRange<Student<RollType, CourseType>> getSortedView() {
+        if (!isSorted) sortStudents();
+        invalidateLookupIndexes();
+        return SortedOrderRange<Student<RollType, CourseType>>(&students, &sortedOrder);
+    }
+
+    // Read-only sorted view; throws runtime_error if no sorted order exists yet
+    SortedOrderRange<const Student<RollType, CourseType>> getSortedView() const {
+        if (!isSorted) {
+            throw std::runtime_error("Students are not sorted yet");
+        }
+        return SortedOrderRange<const Student<RollType, CourseType>>(&students, &sortedOrder);
+    }
+
+    // Get insertion order iterator (writable, so it drops the lookup indexes like the views)
     InsertionOrderIterator<Student<RollType, CourseType>> getInsertionOrderIterator() {
+        invalidateLookupIndexes();
         return InsertionOrderIterator<Student<RollType, CourseType>>(&students, &insertionOrder);
     }
 
-    // Get sorted order iterator
+    InsertionOrderIterator<const Student<RollType, CourseType>> getInsertionOrderIterator() const {
+        return InsertionOrderIterator<const Student<RollType, CourseType>>(&students, &insertionOrder);
+    }
+
+    // Get sorted order iterator (sorts if needed; writable, drops the lookup indexes)
     SortedOrderIterator<Student<RollType, CourseType>> getSortedOrderIterator() {
         if (!isSorted) sortStudents();
+        invalidateLookupIndexes();
         return SortedOrderIterator<Student<RollType, CourseType>>(&students, &sortedOrder);
     }
 
@@ -91,8 +516,35 @@ public:
         return results;
     }
 
-    // Get underlying vector for processing
+    // Find the k students with the highest average grade points
+    // Ties keep storage order; O(n log k)
+    std::vector<int> findTopStudents(size_t k) const {
+        std::vector<int> results(students.size());
+        for (size_t i = 0; i < students.size(); i++) {
+            results[i] = static_cast<int>(i);
+        }
+        k = std::min(k, results.size());
+        std::partial_sort(results.begin(), results.begin() + k, results.end(),
+            [this](int a, int b) {
+                double ga = students[a].getAverageGradePoints();
+                double gb = students[b].getAverageGradePoints();
+                if (ga != gb) return ga > gb;
+                return a < b;
+            });
+        results.resize(k);
+        return results;
+    }
+
+    // Grade point statistics of all enrollments grouped by keys (e.g.
+    // branch, year, course), aggregated in parallel; threads = 0 = auto.
+    // Throws invalid_argument for keys this course type lacks (semester on IIT)
+    AggregateReport aggregate(const std::vector<GroupKey>& keys, int threads = 0) const {
+        return StudentAggregator<RollType, CourseType>(keys).run(students, threads);
+    }
+
+    // Get underlying vector for processing (invalidates the roll, ordered and semester indexes)
     std::vector<Student<RollType, CourseType>>& getStudents() {
+        invalidateLookupIndexes();
         return students;
     }
 
@@ -105,6 +557,14 @@ public:
         if (!isSorted) sortStudents();
         return sortedOrder;
     }
+
+    // Read-only; throws runtime_error if no sorted order exists yet
+    const std::vector<int>& getSortedOrderIndices() const {
+        if (!isSorted) {
+            throw std::runtime_error("Students are not sorted yet");
+        }
+        return sortedOrder;
+    }
 };
 
 #endif // STUDENT_MANAGER_H
\ No newline at end of file
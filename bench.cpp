@@ -0,0 +1,516 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+#include <functional>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include "Student.h"
+#include "StudentManager.h"
+#include "SortingThreads.h"
+#include "SearchIndex.h"
+#include "ConcurrentStudentManager.h"
+#include "StudentIO.h"
+#include "RosterGenerator.h"
+
+using namespace std;
+
+// ============================================================================
+// BENCHMARK HARNESS
+// ============================================================================
+
+/**
+ * Command-line settings for a benchmark run
+ */
+struct BenchOptions {
+    vector<size_t> sizes = {10000, 1000000, 10000000};
+    vector<int> threads = {2, 4, 8, 16, 32};
+    int warmup = 1;
+    int reps = 5;
+    int lookups = 1000;
+    uint64_t seed = 42;
+    string filter;
+    string exportPath = "bench_export.csv";
+    bool json = false;
+};
+
+/**
+ * Summary of one benchmark: all samples are per repetition (or per
+ * operation for latency benchmarks), in milliseconds
+ */
+struct BenchResult {
+    string name;
+    size_t rows;
+    size_t samples;
+    double medianMs;
+    double p99Ms;
+    double minMs;
+    double maxMs;
+};
+
+// Nearest-rank percentile of an already sorted sample set
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > sorted.size()) rank = sorted.size();
+    return sorted[rank - 1];
+}
+
+BenchResult summarize(const string& name, size_t rows, vector<double> samples) {
+    sort(samples.begin(), samples.end());
+    BenchResult result;
+    result.name = name;
+    result.rows = rows;
+    result.samples = samples.size();
+    result.medianMs = percentile(samples, 50);
+    result.p99Ms = percentile(samples, 99);
+    result.minMs = samples.empty() ? 0.0 : samples.front();
+    result.maxMs = samples.empty() ? 0.0 : samples.back();
+    return result;
+}
+
+void printResult(const BenchResult& r, const BenchOptions& opts) {
+    if (opts.json) {
+        cout << "{\"bench\":\"" << r.name << "\",\"rows\":" << r.rows
+             << ",\"samples\":" << r.samples << fixed << setprecision(4)
+             << ",\"median_ms\":" << r.medianMs << ",\"p99_ms\":" << r.p99Ms
+             << ",\"min_ms\":" << r.minMs << ",\"max_ms\":" << r.maxMs << "}" << endl;
+        return;
+    }
+    cout << left << setw(28) << r.name << right << setw(10) << r.rows << setw(9) << r.samples
+         << fixed << setprecision(4) << setw(14) << r.medianMs << setw(14) << r.p99Ms
+         << setw(14) << r.minMs << setw(14) << r.maxMs << endl;
+}
+
+void printTableHeader(const BenchOptions& opts) {
+    if (opts.json) return;
+    cout << left << setw(28) << "Benchmark" << right << setw(10) << "Rows" << setw(9) << "Samples"
+         << setw(14) << "Median (ms)" << setw(14) << "P99 (ms)"
+         << setw(14) << "Min (ms)" << setw(14) << "Max (ms)" << endl;
+    cout << string(103, '-') << endl;
+}
+
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Run setup (untimed) + body (timed) for warmup + reps iterations
+ */
+BenchResult runBenchmark(const string& name, size_t rows, const BenchOptions& opts,
+                         const function<void()>& setup, const function<void()>& body) {
+    vector<double> samples;
+    for (int i = 0; i < opts.warmup + opts.reps; i++) {
+        setup();
+        auto start = chrono::steady_clock::now();
+        body();
+        double ms = elapsedMs(start);
+        if (i >= opts.warmup) samples.push_back(ms);
+    }
+    return summarize(name, rows, samples);
+}
+
+/**
+ * Time each of `ops` calls of op(i) individually - for per-lookup latency
+ */
+BenchResult runLatencyBenchmark(const string& name, size_t rows, int ops,
+                                const function<void(int)>& op) {
+    vector<double> samples;
+    samples.reserve(ops);
+    for (int i = 0; i < ops; i++) {
+        auto start = chrono::steady_clock::now();
+        op(i);
+        samples.push_back(elapsedMs(start));
+    }
+    return summarize(name, rows, samples);
+}
+
+bool selected(const BenchOptions& opts, const string& name) {
+    return opts.filter.empty() || name.find(opts.filter) != string::npos;
+}
+
+// Keeps results observable so the optimizer cannot drop benchmark bodies
+volatile size_t benchSink = 0;
+
+// ============================================================================
+// BENCHMARKS
+// ============================================================================
+
+/**
+ * Fine-grained stats recording as a task pool would do it: `threads` workers
+ * each finish `tasks / threads` tiny tasks and record one ThreadStats per task.
+ * The mutex variant pushes into one shared vector under a lock (the old
+ * statsMutex scheme); the slot variant appends to a cache-line-padded
+ * per-thread slot and aggregates after join.
+ */
+size_t recordStatsWithMutex(int threads, size_t tasks) {
+    mutex statsMutex;
+    vector<ThreadStats> all;
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (size_t i = t; i < tasks; i += threads) {
+                ThreadStats stats{t, 0, 0, 0, 1, i, i, 0, 0, -1};
+                lock_guard<mutex> lock(statsMutex);
+                all.push_back(stats);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    return all.size();
+}
+
+struct alignas(64) PaddedStatsBuffer {
+    vector<ThreadStats> stats;
+};
+
+size_t recordStatsWithSlots(int threads, size_t tasks) {
+    vector<PaddedStatsBuffer> slots(threads);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (size_t i = t; i < tasks; i += threads) {
+                slots[t].stats.push_back(ThreadStats{t, 0, 0, 0, 1, i, i, 0, 0, -1});
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    vector<ThreadStats> all;
+    for (auto& slot : slots) {
+        all.insert(all.end(), slot.stats.begin(), slot.stats.end());
+    }
+    return all.size();
+}
+
+/**
+ * Run every benchmark on one synthetic roster of `rows` rows
+ */
+void runSuite(size_t rows, const BenchOptions& opts) {
+    RosterConfig config;
+    config.seed = opts.seed;
+    RosterGenerator generator(config);
+    string csv = generator.generateCSV(rows);
+
+    // Pre-split course columns for the course-parser benchmarks
+    vector<string> iiitFields, iitFields;
+    {
+        istringstream in(csv);
+        string line;
+        getline(in, line);
+        while (getline(in, line)) {
+            size_t c4 = 0;
+            for (int field = 0; field < 4; field++) c4 = line.find(',', c4) + 1;
+            size_t c5 = line.find(',', c4);
+            iiitFields.push_back(line.substr(c4, c5 - c4));
+            iitFields.push_back(line.substr(c5 + 1));
+        }
+    }
+
+    SortingThreadsManager sorter;
+    sorter.setVerbose(false);
+    sorter.setLogFile("");
+
+    auto iiit = make_unique<IIITStudentManager>();
+    auto iit = make_unique<IITStudentManager>();
+    unique_ptr<istringstream> input;
+
+    if (selected(opts, "csv_parse")) {
+        printResult(runBenchmark("csv_parse", rows, opts,
+            [&] {
+                iiit = make_unique<IIITStudentManager>();
+                iit = make_unique<IITStudentManager>();
+                input = make_unique<istringstream>(csv);
+            },
+            [&] {
+                loadStudentsFromStream(*input, *iiit, *iit, false, 0);
+            }), opts);
+    }
+
+    // Everything below works on one loaded roster
+    iiit = make_unique<IIITStudentManager>();
+    iit = make_unique<IITStudentManager>();
+    {
+        istringstream in(csv);
+        loadStudentsFromStream(in, *iiit, *iit, false, 0);
+    }
+    csv.clear();
+    csv.shrink_to_fit();
+
+    if (selected(opts, "parse_iiit_courses")) {
+        vector<IIITCourse> courses;
+        printResult(runBenchmark("parse_iiit_courses", rows, opts, [] {},
+            [&] {
+                for (const auto& field : iiitFields) {
+                    courses.clear();
+                    parseIIITCourses(field, courses);
+                    benchSink += courses.size();
+                }
+            }), opts);
+    }
+
+    if (selected(opts, "parse_iit_courses")) {
+        vector<IITCourse> courses;
+        printResult(runBenchmark("parse_iit_courses", rows, opts, [] {},
+            [&] {
+                for (const auto& field : iitFields) {
+                    courses.clear();
+                    parseIITCourses(field, courses);
+                    benchSink += courses.size();
+                }
+            }), opts);
+    }
+    iiitFields.clear();
+    iiitFields.shrink_to_fit();
+    iitFields.clear();
+    iitFields.shrink_to_fit();
+
+    if (selected(opts, "manager_sort")) {
+        printResult(runBenchmark("manager_sort", rows, opts, [] {},
+            [&] { iiit->sortStudents(); }), opts);
+    }
+
+    // Binary search straight over the sorted view (no copy into a vector)
+    if (selected(opts, "sorted_view_search")) {
+        if (!iiit->hasSortedOrder()) iiit->sortStudents();
+        auto view = as_const(*iiit).getSortedView();
+        const auto& students = as_const(*iiit).getStudents();
+        printResult(runLatencyBenchmark("sorted_view_search", rows, opts.lookups,
+            [&](int i) {
+                const IIITStudent& probe = students[(static_cast<size_t>(i) * 7919) % students.size()];
+                benchSink += lower_bound(view.begin(), view.end(), probe) - view.begin();
+            }), opts);
+    }
+
+    // Roll number work: roll -> index map, lookups through it, roll-ordered sort
+    if (selected(opts, "roll_index_build")) {
+        printResult(runBenchmark("roll_index_build", rows, opts, [] {},
+            [&] { iiit->buildRollIndex(); }), opts);
+    }
+
+    if (selected(opts, "roll_lookup")) {
+        iiit->buildRollIndex();
+        const auto& students = as_const(*iiit).getStudents();
+        printResult(runLatencyBenchmark("roll_lookup", rows, opts.lookups,
+            [&](int i) {
+                const IIITStudent& probe = students[(static_cast<size_t>(i) * 7919) % students.size()];
+                benchSink += iiit->findByRoll(probe.getRollNumber());
+            }), opts);
+    }
+
+    if (selected(opts, "roll_sort")) {
+        vector<IIITStudent> copy;
+        StudentKeyCompare<IIITStudent> byRoll({StudentSortKey::Roll});
+        printResult(runBenchmark("roll_sort", rows, opts,
+            [&] { copy = as_const(*iiit).getStudents(); },
+            [&] { sort(copy.begin(), copy.end(), byRoll); }), opts);
+    }
+
+    // parallel_sort_t{N} uses the default natural merge, merge_sort_t{N} the
+    // plain top-down merge sort, sample_sort_t{N} the bucket-per-thread sample sort
+    for (SortStrategy strategy : {SortStrategy::NaturalMerge, SortStrategy::MergeSort, SortStrategy::SampleSort}) {
+        string prefix = strategy == SortStrategy::NaturalMerge ? "parallel" : sortStrategyName(strategy);
+        for (int t : opts.threads) {
+            string name = prefix + "_sort_t" + to_string(t);
+            if (!selected(opts, name)) continue;
+            vector<IIITStudent> copy;
+            printResult(runBenchmark(name, rows, opts,
+                [&] { copy = iiit->getStudents(); },
+                [&] { sorter.parallelSort(copy, t, less<IIITStudent>(), strategy); }), opts);
+        }
+    }
+
+    // Same sorts with the workers pinned to CPUs spread over the NUMA nodes
+    // (sample sort also places each bucket's scratch on its sorter's node)
+    sorter.setPinThreads(true);
+    for (SortStrategy strategy : {SortStrategy::NaturalMerge, SortStrategy::SampleSort}) {
+        string prefix = strategy == SortStrategy::NaturalMerge ? "pinned_parallel" : "pinned_sample";
+        for (int t : opts.threads) {
+            string name = prefix + "_sort_t" + to_string(t);
+            if (!selected(opts, name)) continue;
+            vector<IIITStudent> copy;
+            printResult(runBenchmark(name, rows, opts,
+                [&] { copy = iiit->getStudents(); },
+                [&] { sorter.parallelSort(copy, t, less<IIITStudent>(), strategy); }), opts);
+        }
+    }
+    sorter.setPinThreads(false);
+
+    // Re-sorting a sorted roster after 1% new students were appended
+    for (SortStrategy strategy : {SortStrategy::MergeSort, SortStrategy::NaturalMerge, SortStrategy::SampleSort}) {
+        string name = string("resort_appended_") + sortStrategyName(strategy);
+        if (!selected(opts, name)) continue;
+        vector<IIITStudent> base = as_const(*iiit).getStudents();
+        stable_sort(base.begin(), base.end() - base.size() / 100);
+        vector<IIITStudent> copy;
+        printResult(runBenchmark(name, rows, opts,
+            [&] { copy = base; },
+            [&] { sorter.parallelSort(copy, 4, less<IIITStudent>(), strategy); }), opts);
+    }
+
+    // One stats record per 16 rows - the task granularity of a fine-grained pool
+    size_t statTasks = max<size_t>(rows / 16, 1000);
+    for (int t : opts.threads) {
+        string name = "stats_mutex_t" + to_string(t);
+        if (selected(opts, name)) {
+            printResult(runBenchmark(name, statTasks, opts, [] {},
+                [&] { benchSink += recordStatsWithMutex(t, statTasks); }), opts);
+        }
+        name = "stats_slots_t" + to_string(t);
+        if (selected(opts, name)) {
+            printResult(runBenchmark(name, statTasks, opts, [] {},
+                [&] { benchSink += recordStatsWithSlots(t, statTasks); }), opts);
+        }
+    }
+
+    // Full branch x year x course grade report over every enrollment
+    vector<GroupKey> reportKeys = {GroupKey::Branch, GroupKey::Year, GroupKey::Course};
+    for (int t : opts.threads) {
+        string name = "aggregate_t" + to_string(t);
+        if (!selected(opts, name)) continue;
+        printResult(runBenchmark(name, rows, opts, [] {},
+            [&] { benchSink += as_const(*iiit).aggregate(reportKeys, t).groups.size(); }), opts);
+    }
+
+    SearchIndex<IIITCourse> index;
+    if (selected(opts, "build_index")) {
+        printResult(runBenchmark("build_index", rows, opts,
+            [&] { index.clear(); },
+            [&] { index.buildIndex(iiit->getStudents()); }), opts);
+    }
+    if (index.getIndexedStudentCount() != iiit->getTotalStudents()) {
+        index.clear();
+        index.buildIndex(iiit->getStudents());
+    }
+
+    if (selected(opts, "index_lookup")) {
+        vector<string> codes = index.getAllCourses();
+        printResult(runLatencyBenchmark("index_lookup", rows, opts.lookups,
+            [&](int i) {
+                const string& code = codes[i % codes.size()];
+                benchSink += index.findStudentsByGradeInCourse(code, 4 + (i % 7)).size();
+            }), opts);
+    }
+
+    // Roll lookups on a snapshot, idle vs. while a writer keeps appending
+    // (and publishing) the second half of the roster in batches
+    for (bool ingest : {false, true}) {
+        string name = ingest ? "concurrent_lookup_ingest" : "concurrent_lookup_idle";
+        if (!selected(opts, name)) continue;
+        const auto& students = iiit->getStudents();
+        size_t half = students.size() / 2;
+        ConcurrentStudentManager<PackedRoll, IIITCourse> store;
+        store.addStudents(vector<IIITStudent>(students.begin(), students.begin() + half));
+
+        atomic<bool> stop(false);
+        thread writer;
+        if (ingest) {
+            writer = thread([&] {
+                for (size_t i = half; !stop.load(memory_order_relaxed); i++) {
+                    if (i == students.size()) i = half;
+                    store.addStudent(students[i]);
+                }
+            });
+        }
+        printResult(runLatencyBenchmark(name, rows, opts.lookups,
+            [&](int i) {
+                auto view = store.snapshot();
+                size_t idx = (static_cast<size_t>(i) * 7919) % max<size_t>(half, 1);
+                benchSink += view->findByRoll(students[idx].getRollNumber()) != nullptr;
+            }), opts);
+        stop = true;
+        if (writer.joinable()) writer.join();
+    }
+
+    if (selected(opts, "export_csv")) {
+        printResult(runBenchmark("export_csv", rows, opts, [] {},
+            [&] { benchSink += exportSortedCSV(*iiit, *iit, opts.exportPath); }), opts);
+        remove(opts.exportPath.c_str());
+    }
+}
+
+// ============================================================================
+// COMMAND LINE
+// ============================================================================
+
+template<typename Number>
+vector<Number> parseList(const string& text) {
+    vector<Number> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ',')) {
+        size_t used = 0;
+        long long value = stoll(item, &used);
+        if (used != item.size() || value <= 0) {
+            throw invalid_argument("Invalid list entry '" + item + "'");
+        }
+        values.push_back(static_cast<Number>(value));
+    }
+    return values;
+}
+
+void printUsage() {
+    cout << "Usage: erp_bench [options]" << endl;
+    cout << "  --sizes N,N,...     Roster sizes (default 10000,1000000,10000000)" << endl;
+    cout << "  --threads N,N,...   Thread counts for the sorts (default 2,4,8,16,32)" << endl;
+    cout << "  --reps N            Timed repetitions (default 5)" << endl;
+    cout << "  --warmup N          Untimed warmup runs (default 1)" << endl;
+    cout << "  --lookups N         Lookups timed individually (default 1000)" << endl;
+    cout << "  --seed N            Roster generator seed (default 42)" << endl;
+    cout << "  --filter TEXT       Only run benchmarks whose name contains TEXT" << endl;
+    cout << "  --export-path F     Scratch file for export_csv (default bench_export.csv)" << endl;
+    cout << "  --json              One JSON line per result instead of a table" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opts;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            auto value = [&]() -> string {
+                if (i + 1 >= argc) throw invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+
+            if (arg == "--sizes") opts.sizes = parseList<size_t>(value());
+            else if (arg == "--threads") opts.threads = parseList<int>(value());
+            else if (arg == "--reps") opts.reps = stoi(value());
+            else if (arg == "--warmup") opts.warmup = stoi(value());
+            else if (arg == "--lookups") opts.lookups = stoi(value());
+            else if (arg == "--seed") opts.seed = stoull(value());
+            else if (arg == "--filter") opts.filter = value();
+            else if (arg == "--export-path") opts.exportPath = value();
+            else if (arg == "--json") opts.json = true;
+            else if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return 0;
+            } else {
+                throw invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (opts.reps < 1 || opts.warmup < 0 || opts.lookups < 1) {
+            throw invalid_argument("--reps and --lookups must be >= 1, --warmup >= 0");
+        }
+
+        printTableHeader(opts);
+        for (size_t rows : opts.sizes) {
+            runSuite(rows, opts);
+        }
+
+    } catch (const exception& e) {
+        cerr << "❌ ERROR: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+/**
+ * Closed-loop load generator for `erp_system serve`
+ * Each connection sends one request, waits for its response line and
+ * records the round-trip time; QPS and latency percentiles are reported
+ * over all connections
+ */
+
+struct LoadOptions {
+    string socketPath;
+    int port = -1;
+    int connections = 4;
+    long requests = 10000;       // Per connection
+    double durationSec = 0;      // If > 0, run for this long instead
+    string queriesFile;
+    string rosterFile;
+    bool json = false;
+};
+
+struct ConnectionResult {
+    vector<double> latenciesUs;
+    long errors = 0;
+};
+
+void printUsage() {
+    cout << "Usage: erp_loadgen (--socket PATH | --port N) [options]" << endl;
+    cout << "  --connections N   Concurrent connections (default 4)" << endl;
+    cout << "  --requests N      Requests per connection (default 10000)" << endl;
+    cout << "  --duration S      Run for S seconds instead of a request count" << endl;
+    cout << "  --queries FILE    Request lines to cycle through" << endl;
+    cout << "  --roster FILE     Build 'GET roll' requests from a students.csv roster" << endl;
+    cout << "  --json            Print the summary as one JSON line" << endl;
+    cout << "Without --queries/--roster a mix of TOPK, FILTER, RANGE and PING is sent." << endl;
+}
+
+int connectToServer(const LoadOptions& opts) {
+    int fd;
+    if (!opts.socketPath.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, opts.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(opts.port));
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        if (fd >= 0) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) return fd;
+    }
+    int err = errno;
+    if (fd >= 0) close(fd);
+    throw runtime_error(string("Could not connect: ") + strerror(err));
+}
+
+vector<string> loadRequests(const LoadOptions& opts) {
+    vector<string> requests;
+    if (!opts.queriesFile.empty()) {
+        ifstream in(opts.queriesFile);
+        if (!in.is_open()) throw runtime_error("Could not open file: " + opts.queriesFile);
+        string line;
+        while (getline(in, line)) {
+            if (!line.empty()) requests.push_back(line);
+        }
+    } else if (!opts.rosterFile.empty()) {
+        ifstream in(opts.rosterFile);
+        if (!in.is_open()) throw runtime_error("Could not open file: " + opts.rosterFile);
+        string line;
+        getline(in, line); // Header
+        while (getline(in, line) && requests.size() < 100000) {
+            string roll = line.substr(0, line.find(','));
+            if (!roll.empty()) requests.push_back("GET " + roll);
+        }
+    } else {
+        requests = {"TOPK 10", "FILTER DSA 8", "RANGE 2021 2022", "PING", "iit FILTER 101 9", "iit TOPK 5"};
+    }
+    if (requests.empty()) throw runtime_error("No requests to send");
+    return requests;
+}
+
+void runConnection(const LoadOptions& opts, const vector<string>& requests, size_t offset,
+                   chrono::steady_clock::time_point deadline, ConnectionResult& result) {
+    int fd = connectToServer(opts);
+    string pending;
+    char buf[65536];
+
+    for (long i = 0; opts.durationSec > 0 || i < opts.requests; i++) {
+        auto start = chrono::steady_clock::now();
+        if (opts.durationSec > 0 && start >= deadline) break;
+
+        string request = requests[(offset + i) % requests.size()] + "\n";
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+            result.errors++;
+            break;
+        }
+
+        size_t newline;
+        bool ok = true;
+        while ((newline = pending.find('\n')) == string::npos) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                ok = false;
+                break;
+            }
+            pending.append(buf, n);
+        }
+        if (!ok) {
+            result.errors++;
+            break;
+        }
+
+        result.latenciesUs.push_back(
+            chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        if (pending.compare(0, 3, "ERR") == 0) result.errors++;
+        pending.erase(0, newline + 1);
+    }
+    close(fd);
+}
+
+double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    rank = max<size_t>(1, min(rank, sorted.size()));
+    return sorted[rank - 1];
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions opts;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            auto value = [&]() -> string {
+                if (i + 1 >= argc) throw invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+
+            if (arg == "--socket") opts.socketPath = value();
+            else if (arg == "--port") opts.port = stoi(value());
+            else if (arg == "--connections") opts.connections = stoi(value());
+            else if (arg == "--requests") opts.requests = stol(value());
+            else if (arg == "--duration") opts.durationSec = stod(value());
+            else if (arg == "--queries") opts.queriesFile = value();
+            else if (arg == "--roster") opts.rosterFile = value();
+            else if (arg == "--json") opts.json = true;
+            else if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return 0;
+            } else {
+                throw invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (opts.socketPath.empty() == (opts.port < 0)) {
+            printUsage();
+            return 1;
+        }
+        if (opts.connections < 1 || opts.requests < 1) {
+            throw invalid_argument("--connections and --requests must be >= 1");
+        }
+
+        vector<string> requests = loadRequests(opts);
+        vector<ConnectionResult> results(opts.connections);
+        vector<thread> clients;
+        vector<string> failures(opts.connections);
+
+        auto start = chrono::steady_clock::now();
+        auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(opts.durationSec));
+        for (int c = 0; c < opts.connections; c++) {
+            clients.emplace_back([&, c] {
+                try {
+                    runConnection(opts, requests, c * 7919, deadline, results[c]);
+                } catch (const exception& e) {
+                    failures[c] = e.what();
+                }
+            });
+        }
+        for (auto& t : clients) t.join();
+        double elapsedSec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        for (const auto& failure : failures) {
+            if (!failure.empty()) throw runtime_error(failure);
+        }
+
+        vector<double> all;
+        long errors = 0;
+        for (auto& r : results) {
+            all.insert(all.end(), r.latenciesUs.begin(), r.latenciesUs.end());
+            errors += r.errors;
+        }
+        sort(all.begin(), all.end());
+        double qps = elapsedSec > 0 ? all.size() / elapsedSec : 0.0;
+
+        cout << fixed << setprecision(1);
+        if (opts.json) {
+            cout << "{\"requests\":" << all.size() << ",\"errors\":" << errors
+                 << ",\"connections\":" << opts.connections << ",\"seconds\":" << setprecision(3) << elapsedSec
+                 << setprecision(1) << ",\"qps\":" << qps << ",\"p50_us\":" << percentile(all, 50)
+                 << ",\"p99_us\":" << percentile(all, 99)
+                 << ",\"max_us\":" << (all.empty() ? 0.0 : all.back()) << "}" << endl;
+        } else {
+            cout << "Requests:    " << all.size() << " (" << errors << " errors) over "
+                 << opts.connections << " connections" << endl;
+            cout << "Elapsed:     " << setprecision(3) << elapsedSec << " s" << setprecision(1) << endl;
+            cout << "Throughput:  " << qps << " req/s" << endl;
+            cout << "Latency:     p50 " << percentile(all, 50) << " us, p99 " << percentile(all, 99)
+                 << " us, max " << (all.empty() ? 0.0 : all.back()) << " us" << endl;
+        }
+
+    } catch (const exception& e) {
+        cerr << "❌ ERROR: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
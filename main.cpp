@@ -8,27 +8,44 @@
 #include <limits>
 #include <iomanip>
 #include <ctime>
+#include <chrono>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <csignal>
+#include <thread>
+#include <atomic>
 #include "Student.h"
 #include "StudentManager.h"
 #include "Iterator.h"
 #include "SortingThreads.h"
 #include "SearchIndex.h"
+#include "CSVWriter.h"
+#include "Snapshot.h"
+#include "StudentIO.h"
+#include "Metrics.h"
+#include "QueryServer.h"
+#include "IngestPipeline.h"
+#include "ExternalSort.h"
+#include "ConcurrentStudentManager.h"
 
 using namespace std;
 
-// Type aliases for IIIT-Delhi system (string roll numbers, string course codes)
-using IIITStudent = Student<string, IIITCourse>;
-using IIITStudentManager = StudentManager<string, IIITCourse>;
-
-// Type aliases for IIT-Delhi system (integer roll numbers, integer course codes)
-using IITStudent = Student<unsigned int, IITCourse>;
-using IITStudentManager = StudentManager<unsigned int, IITCourse>;
-
 // Global managers
 IIITStudentManager iiitManager;
 IITStudentManager iitManager;
 SortingThreadsManager sortingManager;
 
+// Global search indexes (rebuilt when stale, persisted in snapshots)
+SearchIndex<IIITCourse> iiitSearchIndex;
+SearchIndex<IITCourse> iitSearchIndex;
+
+// Students appended by `serve --ingest` while the server is answering; GET
+// falls back to their published snapshot when the loaded data has no match
+ConcurrentStudentManager<PackedRoll, IIITCourse> iiitLiveStore;
+ConcurrentStudentManager<unsigned int, IITCourse> iitLiveStore;
+
 // ============================================================================
 // UTILITY FUNCTIONS FOR INPUT VALIDATION AND ERROR HANDLING
 // ============================================================================
@@ -195,118 +212,6 @@ char getValidatedGrade() {
     return grade;
 }
 
-// ============================================================================
-// CSV PARSING WITH ERROR HANDLING
-// ============================================================================
-
-/**
- * Parse IIIT courses from CSV string with error handling
- * Format: Code:Semester:Grade;Code:Semester:Grade
- */
-void parseIIITCourses(const string& coursesStr, vector<IIITCourse>& courses) {
-    if (coursesStr.empty()) return;
-    
-    try {
-        stringstream ss(coursesStr);
-        string courseStr;
-        int lineCount = 0;
-        
-        while (getline(ss, courseStr, ';')) {
-            lineCount++;
-            if (courseStr.empty()) continue;
-            
-            try {
-                size_t pos1 = courseStr.find(':');
-                size_t pos2 = courseStr.rfind(':');
-                
-                if (pos1 == string::npos || pos2 == string::npos || pos1 == pos2) {
-                    cerr << "⚠️  WARNING: Malformed course entry #" << lineCount << ": " 
-                         << courseStr << " (skipping)" << endl;
-                    continue;
-                }
-                
-                string code = courseStr.substr(0, pos1);
-                
-                if (code.empty()) {
-                    cerr << "⚠️  WARNING: Empty course code in entry #" << lineCount << " (skipping)" << endl;
-                    continue;
-                }
-                
-                int sem = stoi(courseStr.substr(pos1 + 1, pos2 - pos1 - 1));
-                char grade = courseStr[pos2 + 1];
-                
-                if (grade != 'A' && grade != 'B' && grade != 'C' && grade != 'D') {
-                    cerr << "⚠️  WARNING: Invalid grade '" << grade << "' in entry #" << lineCount 
-                         << " (skipping)" << endl;
-                    continue;
-                }
-                
-                courses.push_back(IIITCourse(code, sem, grade));
-            } catch (const invalid_argument& e) {
-                cerr << "⚠️  WARNING: Invalid course data in entry #" << lineCount 
-                     << " - " << e.what() << " (skipping)" << endl;
-                continue;
-            } catch (const exception& e) {
-                cerr << "⚠️  WARNING: Error parsing course entry #" << lineCount 
-                     << " - " << e.what() << " (skipping)" << endl;
-                continue;
-            }
-        }
-    } catch (const exception& e) {
-        cerr << "⚠️  WARNING: Error parsing IIIT courses: " << e.what() << endl;
-    }
-}
-
-/**
- * Parse IIT courses from CSV string with error handling
- * Format: Code:Grade;Code:Grade
- */
-void parseIITCourses(const string& coursesStr, vector<IITCourse>& courses) {
-    if (coursesStr.empty()) return;
-    
-    try {
-        stringstream ss(coursesStr);
-        string courseStr;
-        int lineCount = 0;
-        
-        while (getline(ss, courseStr, ';')) {
-            lineCount++;
-            if (courseStr.empty()) continue;
-            
-            try {
-                size_t pos = courseStr.find(':');
-                
-                if (pos == string::npos) {
-                    cerr << "⚠️  WARNING: Malformed IIT course entry #" << lineCount 
-                         << ": " << courseStr << " (skipping)" << endl;
-                    continue;
-                }
-                
-                int code = stoi(courseStr.substr(0, pos));
-                char grade = courseStr[pos + 1];
-                
-                if (grade != 'A' && grade != 'B' && grade != 'C' && grade != 'D') {
-                    cerr << "⚠️  WARNING: Invalid grade '" << grade << "' in IIT entry #" << lineCount 
-                         << " (skipping)" << endl;
-                    continue;
-                }
-                
-                courses.push_back(IITCourse(code, grade));
-            } catch (const invalid_argument& e) {
-                cerr << "⚠️  WARNING: Invalid IIT course data in entry #" << lineCount 
-                     << " - " << e.what() << " (skipping)" << endl;
-                continue;
-            } catch (const exception& e) {
-                cerr << "⚠️  WARNING: Error parsing IIT course entry #" << lineCount 
-                     << " - " << e.what() << " (skipping)" << endl;
-                continue;
-            }
-        }
-    } catch (const exception& e) {
-        cerr << "⚠️  WARNING: Error parsing IIT courses: " << e.what() << endl;
-    }
-}
-
 // ============================================================================
 // FILE LOADING WITH ERROR HANDLING
 // ============================================================================
@@ -326,130 +231,34 @@ void loadStudentsFromCSV() {
             filename = "students.csv";
         }
         
-        ifstream file(filename);
+        // A file produced by saveSortedToCSV is already in sorted order,
+        // so the sorted view can be rebuilt without sorting again
+        string presortedAnswer;
+        cout << "Is this a sorted export (skip sorting)? (y/N): ";
+        getline(cin, presortedAnswer);
+        bool presorted = !presortedAnswer.empty() && 
+                         (presortedAnswer[0] == 'y' || presortedAnswer[0] == 'Y');
         
-        if (!file.is_open()) {
-            throw runtime_error("Could not open file: " + filename);
-        }
-        
-        string line;
-        
-        if (!getline(file, line)) {
-            throw runtime_error("File is empty or cannot be read");
-        }
-        
-        int successCount = 0;
-        int errorCount = 0;
-        int lineNumber = 1;
-        
-        while (getline(file, line) && successCount < 3000) {
-            lineNumber++;
-            
-            try {
-                if (line.empty()) continue;
-                
-                stringstream ss(line);
-                string rollStr, name, branch, yearStr, iiitCoursesStr, iitCoursesStr;
-                
-                if (!getline(ss, rollStr, ',')) {
-                    throw runtime_error("Missing roll number");
-                }
-                
-                if (!getline(ss, name, ',')) {
-                    throw runtime_error("Missing name");
-                }
-                
-                if (!getline(ss, branch, ',')) {
-                    throw runtime_error("Missing branch");
-                }
-                
-                if (!getline(ss, yearStr, ',')) {
-                    throw runtime_error("Missing start year");
-                }
-                
-                if (!getline(ss, iiitCoursesStr, ',')) {
-                    iiitCoursesStr = "";
-                }
-                
-                if (!getline(ss, iitCoursesStr, ',')) {
-                    iitCoursesStr = "";
-                }
-                
-                if (rollStr.empty() || name.empty()) {
-                    cerr << "⚠️  WARNING: Line " << lineNumber << " - Empty roll or name (skipping)" << endl;
-                    errorCount++;
-                    continue;
-                }
-                
-                int year;
-                try {
-                    year = stoi(yearStr);
-                    if (year < 1900 || year > 2100) {
-                        throw out_of_range("Year out of reasonable range");
-                    }
-                } catch (const exception& e) {
-                    cerr << "⚠️  WARNING: Line " << lineNumber << " - Invalid year '" << yearStr 
-                         << "' (skipping)" << endl;
-                    errorCount++;
-                    continue;
-                }
-                
-                // Add to IIIT system
-                try {
-                    IIITStudent iiitStudent(rollStr, name, branch, year);
-                    vector<IIITCourse> iiitCourses;
-                    parseIIITCourses(iiitCoursesStr, iiitCourses);
-                    
-                    for (const auto& course : iiitCourses) {
-                        iiitStudent.addCourse(course);
-                    }
-                    
-                    iiitManager.addStudent(iiitStudent);
-                } catch (const exception& e) {
-                    cerr << "⚠️  WARNING: Line " << lineNumber << " - Failed to add IIIT student: " 
-                         << e.what() << endl;
-                    errorCount++;
-                }
-                
-                // Add to IIT system (only if roll number is numeric)
-                try {
-                    unsigned int rollNum = stoul(rollStr);
-                    IITStudent iitStudent(rollNum, name, branch, year);
-                    vector<IITCourse> iitCourses;
-                    parseIITCourses(iitCoursesStr, iitCourses);
-                    
-                    for (const auto& course : iitCourses) {
-                        iitStudent.addCourse(course);
-                    }
-                    
-                    iitManager.addStudent(iitStudent);
-                } catch (const invalid_argument&) {
-                    // Skip for non-numeric roll numbers (this is expected)
-                } catch (const exception& e) {
-                    cerr << "⚠️  WARNING: Line " << lineNumber << " - Failed to add IIT student: " 
-                         << e.what() << endl;
-                }
-                
-                successCount++;
-            } catch (const exception& e) {
-                cerr << "⚠️  WARNING: Line " << lineNumber << " - " << e.what() << " (skipping)" << endl;
-                errorCount++;
-                continue;
-            }
-        }
-        
-        file.close();
+        LoadResult result = loadStudentsFromFile(filename, iiitManager, iitManager, presorted, 3000);
         
         cout << "\n" << string(70, '=') << endl;
         cout << "✓ CSV Loading Complete" << endl;
-        cout << "  Successfully loaded: " << successCount << " students" << endl;
-        cout << "  Errors encountered: " << errorCount << " records skipped" << endl;
+        cout << "  Successfully loaded: " << result.successCount << " students" << endl;
+        cout << "  Errors encountered: " << result.errorCount << " records skipped" << endl;
         cout << string(70, '=') << endl;
         
-        if (successCount == 0) {
+        if (result.successCount == 0) {
             cerr << "\n❌ ERROR: No students were loaded from the CSV file!" << endl;
         }
         
+        if (presorted) {
+            if (result.presortedApplied) {
+                cout << "✓ Presorted file: sorted order restored without sorting" << endl;
+            } else {
+                cout << "⚠️  WARNING: Data is not in sorted order - sorted normally instead" << endl;
+            }
+        }
+        
     } catch (const ifstream::failure& e) {
         cerr << "\n❌ FILE ERROR: " << e.what() << endl;
     } catch (const runtime_error& e) {
@@ -476,39 +285,36 @@ void searchStudentIIIT() {
         
         string rollNumber = getValidatedString("\nEnter roll number to search: ");
         
-        bool found = false;
-        auto& students = iiitManager.getStudents();
+        // Read-only access keeps the roll index, built by the first search
+        // and kept current by addStudent, so later searches are O(1)
+        if (!iiitManager.hasRollIndex()) iiitManager.buildRollIndex();
+        const auto& students = std::as_const(iiitManager).getStudents();
+        int index = iiitManager.findByRoll(PackedRoll(rollNumber));
         
         cout << "\n" << string(70, '=') << endl;
         cout << "Search Results for Roll Number: " << rollNumber << endl;
         cout << string(70, '=') << endl;
         
-        for (size_t i = 0; i < students.size(); i++) {
-            if (students[i].getRollNumber() == rollNumber) {
-                cout << "\n✓ Student Found!" << endl;
-                cout << "\nStudent Details:" << endl;
-                cout << "  Roll Number: " << students[i].getRollNumber() << endl;
-                cout << "  Name: " << students[i].getName() << endl;
-                cout << "  Branch: " << students[i].getBranch() << endl;
-                cout << "  Start Year: " << students[i].getStartYear() << endl;
-                cout << "  Total Courses: " << students[i].getCourses().size() << endl;
-                
-                if (!students[i].getCourses().empty()) {
-                    cout << "\n  Courses Taken:" << endl;
-                    int courseNum = 1;
-                    for (const auto& course : students[i].getCourses()) {
-                        cout << "    " << courseNum++ << ". Code: " << course.code 
-                             << " | Semester: " << course.semester 
-                             << " | Grade: " << course.grade << endl;
-                    }
+        if (index >= 0) {
+            const auto& student = students[index];
+            cout << "\n✓ Student Found!" << endl;
+            cout << "\nStudent Details:" << endl;
+            cout << "  Roll Number: " << student.getRollNumber() << endl;
+            cout << "  Name: " << student.getName() << endl;
+            cout << "  Branch: " << student.getBranch() << endl;
+            cout << "  Start Year: " << student.getStartYear() << endl;
+            cout << "  Total Courses: " << student.getCourses().size() << endl;
+            
+            if (!student.getCourses().empty()) {
+                cout << "\n  Courses Taken:" << endl;
+                int courseNum = 1;
+                for (const auto& course : student.getCourses()) {
+                    cout << "    " << courseNum++ << ". Code: " << course.code 
+                         << " | Semester: " << course.semester 
+                         << " | Grade: " << course.grade << endl;
                 }
-                
-                found = true;
-                break;
             }
-        }
-        
-        if (!found) {
+        } else {
             cout << "\n❌ No student found with roll number: " << rollNumber << endl;
         }
         
@@ -533,38 +339,35 @@ void searchStudentIIT() {
         cout << "\nEnter roll number to search (positive integer): ";
         unsigned int rollNumber = getValidatedUnsignedInt(1, 999999);
         
-        bool found = false;
-        auto& students = iitManager.getStudents();
+        // Read-only access keeps the roll index, built by the first search
+        // and kept current by addStudent, so later searches are O(1)
+        if (!iitManager.hasRollIndex()) iitManager.buildRollIndex();
+        const auto& students = std::as_const(iitManager).getStudents();
+        int index = iitManager.findByRoll(rollNumber);
         
         cout << "\n" << string(70, '=') << endl;
         cout << "Search Results for Roll Number: " << rollNumber << endl;
         cout << string(70, '=') << endl;
         
-        for (size_t i = 0; i < students.size(); i++) {
-            if (students[i].getRollNumber() == rollNumber) {
-                cout << "\n✓ Student Found!" << endl;
-                cout << "\nStudent Details:" << endl;
-                cout << "  Roll Number: " << students[i].getRollNumber() << endl;
-                cout << "  Name: " << students[i].getName() << endl;
-                cout << "  Branch: " << students[i].getBranch() << endl;
-                cout << "  Start Year: " << students[i].getStartYear() << endl;
-                cout << "  Total Courses: " << students[i].getCourses().size() << endl;
-                
-                if (!students[i].getCourses().empty()) {
-                    cout << "\n  Courses Taken:" << endl;
-                    int courseNum = 1;
-                    for (const auto& course : students[i].getCourses()) {
-                        cout << "    " << courseNum++ << ". Code: " << course.code 
-                             << " | Grade: " << course.grade << endl;
-                    }
+        if (index >= 0) {
+            const auto& student = students[index];
+            cout << "\n✓ Student Found!" << endl;
+            cout << "\nStudent Details:" << endl;
+            cout << "  Roll Number: " << student.getRollNumber() << endl;
+            cout << "  Name: " << student.getName() << endl;
+            cout << "  Branch: " << student.getBranch() << endl;
+            cout << "  Start Year: " << student.getStartYear() << endl;
+            cout << "  Total Courses: " << student.getCourses().size() << endl;
+            
+            if (!student.getCourses().empty()) {
+                cout << "\n  Courses Taken:" << endl;
+                int courseNum = 1;
+                for (const auto& course : student.getCourses()) {
+                    cout << "    " << courseNum++ << ". Code: " << course.code 
+                         << " | Grade: " << course.grade << endl;
                 }
-                
-                found = true;
-                break;
             }
-        }
-        
-        if (!found) {
+        } else {
             cout << "\n❌ No student found with roll number: " << rollNumber << endl;
         }
         
@@ -595,7 +398,7 @@ void addStudentIIIT() {
         cout << "Start Year: ";
         int year = getValidatedInteger(1900, 2100);
         
-        IIITStudent student(roll, name, branch, year);
+        IIITStudent student(PackedRoll(roll), name, branch, year);
         
         cout << "\nNumber of courses: ";
         int numCourses = getValidatedInteger(0, 20);
@@ -743,41 +546,11 @@ void displayStudentsIIT() {
 /**
  * Save sorted students to CSV file
  */
-template<typename RollType, typename CourseType>
-void saveSortedToCSV(StudentManager<RollType, CourseType>& manager, const string& filename) {
+template<typename RollType, typename CourseType, typename TwinRoll, typename TwinCourse>
+void saveSortedToCSV(StudentManager<RollType, CourseType>& manager,
+                     const StudentManager<TwinRoll, TwinCourse>& twins, const string& filename) {
     try {
-        ofstream outFile(filename);
-        
-        if (!outFile.is_open()) {
-            throw runtime_error("Could not create file: " + filename);
-        }
-        
-        // Write header
-        outFile << "RollNumber,Name,Branch,StartYear,Courses" << endl;
-        
-        // Get students in sorted order
-        manager.sortStudents();
-        auto& students = manager.getStudents();
-        auto sortedIterator = manager.getSortedOrderIterator();
-        
-        size_t count = sortedIterator.getSize();
-        for (size_t i = 0; i < count; i++) {
-            auto& student = sortedIterator[i];
-            
-            // Write basic info
-            outFile << student.getRollNumber() << ","
-                   << student.getName() << ","
-                   << student.getBranch() << ","
-                   << student.getStartYear() << ",";
-            
-            // Write courses (simplified format)
-            const auto& courses = student.getCourses();
-            outFile << courses.size();
-            
-            outFile << endl;
-        }
-        
-        outFile.close();
+        size_t count = exportSortedCSV(manager, twins, filename);
         
         cout << "\n✓ Sorted students saved to: " << filename << endl;
         cout << "  Total students saved: " << count << endl;
@@ -791,6 +564,44 @@ void saveSortedToCSV(StudentManager<RollType, CourseType>& manager, const string
 // PARALLEL SORTING WITH ERROR HANDLING AND CSV EXPORT
 // ============================================================================
 
+/**
+ * "auto" for SortingThreadsManager::AUTO_THREADS, else the count
+ */
+string threadCountLabel(int numThreads) {
+    return numThreads == SortingThreadsManager::AUTO_THREADS ? "auto" : to_string(numThreads);
+}
+
+/**
+ * Parallel-sort a manager's storage in place by the given comparator
+ * The sorted view becomes the identity and the (position-based) search
+ * index is invalidated
+ */
+template<typename RollType, typename CourseType, typename Compare>
+void sortManagerInPlace(StudentManager<RollType, CourseType>& manager, SearchIndex<CourseType>& index,
+                        int numThreads, Compare comp) {
+    sortingManager.parallelSort(manager.getStudents(), numThreads, comp);
+    
+    // Storage is now physically sorted - sorted view is the identity
+    manager.markPresorted(comp);
+    
+    // Index postings refer to storage positions, which just moved
+    index.clear();
+}
+
+/**
+ * Rebuild a search index if it does not cover the current students, or
+ * courses were added to them (addCourse) since it was built
+ */
+template<typename RollType, typename CourseType>
+void ensureSearchIndex(StudentManager<RollType, CourseType>& manager, SearchIndex<CourseType>& index) {
+    if (index.getIndexedStudentCount() != manager.getTotalStudents() ||
+        index.getCourseVersion() != manager.getCourseVersion()) {
+        index.clear();
+        index.buildIndex(as_const(manager).getStudents());
+        index.setCourseVersion(manager.getCourseVersion());
+    }
+}
+
 /**
  * Perform parallel sorting on IIIT students with export to CSV
  */
@@ -806,22 +617,20 @@ void sortIIITStudents() {
         cout << "Parallel Sort - IIIT Students" << endl;
         cout << string(70, '=') << endl;
         
-        cout << "Number of threads (2-8): ";
-        int numThreads = getValidatedInteger(2, 8);
-        
-        auto& students = iiitManager.getStudents();
+        cout << "Number of threads (0 = auto, 1-" << SortingThreadsManager::MAX_THREADS << "): ";
+        int numThreads = getValidatedInteger(0, SortingThreadsManager::MAX_THREADS);
         
-        cout << "\nSorting " << students.size() << " IIIT students using " 
-             << numThreads << " threads..." << endl;
+        cout << "\nSorting " << iiitManager.getTotalStudents() << " IIIT students using " 
+             << threadCountLabel(numThreads) << " threads..." << endl;
         
-        sortingManager.parallelSort(students, numThreads);
+        sortManagerInPlace(iiitManager, iiitSearchIndex, numThreads, less<IIITStudent>());
         
         cout << "\n✓ Sorting completed successfully!" << endl;
         
         // Save sorted students to CSV
         string outputFilename = "sorted_iiit_students.csv";
         cout << "\nSaving sorted students to CSV..." << endl;
-        saveSortedToCSV(iiitManager, outputFilename);
+        saveSortedToCSV(iiitManager, iitManager, outputFilename);
         
     } catch (const exception& e) {
         cerr << "\n❌ ERROR: Sorting failed - " << e.what() << endl;
@@ -843,22 +652,20 @@ void sortIITStudents() {
         cout << "Parallel Sort - IIT Students" << endl;
         cout << string(70, '=') << endl;
         
-        cout << "Number of threads (2-8): ";
-        int numThreads = getValidatedInteger(2, 8);
+        cout << "Number of threads (0 = auto, 1-" << SortingThreadsManager::MAX_THREADS << "): ";
+        int numThreads = getValidatedInteger(0, SortingThreadsManager::MAX_THREADS);
         
-        auto& students = iitManager.getStudents();
+        cout << "\nSorting " << iitManager.getTotalStudents() << " IIT students using " 
+             << threadCountLabel(numThreads) << " threads..." << endl;
         
-        cout << "\nSorting " << students.size() << " IIT students using " 
-             << numThreads << " threads..." << endl;
-        
-        sortingManager.parallelSort(students, numThreads);
+        sortManagerInPlace(iitManager, iitSearchIndex, numThreads, less<IITStudent>());
         
         cout << "\n✓ Sorting completed successfully!" << endl;
         
         // Save sorted students to CSV
         string outputFilename = "sorted_iit_students.csv";
         cout << "\nSaving sorted students to CSV..." << endl;
-        saveSortedToCSV(iitManager, outputFilename);
+        saveSortedToCSV(iitManager, iiitManager, outputFilename);
         
     } catch (const exception& e) {
         cerr << "\n❌ ERROR: Sorting failed - " << e.what() << endl;
@@ -883,8 +690,8 @@ void demonstrateSearchIndex() {
         cout << "Search Index Demo - Find High Performers" << endl;
         cout << string(70, '=') << endl;
         
-        SearchIndex<IIITCourse> searchIndex;
-        searchIndex.buildIndex(iiitManager.getStudents());
+        SearchIndex<IIITCourse>& searchIndex = iiitSearchIndex;
+        ensureSearchIndex(iiitManager, searchIndex);
         
         searchIndex.printStatistics();
         
@@ -907,6 +714,969 @@ void demonstrateSearchIndex() {
     }
 }
 
+// ============================================================================
+// BINARY SNAPSHOTS
+// ============================================================================
+
+/**
+ * Save both systems, sorted orders and search indexes to a binary snapshot
+ */
+void saveSnapshotFile() {
+    try {
+        if (iiitManager.getTotalStudents() == 0 && iitManager.getTotalStudents() == 0) {
+            cout << "\n❌ ERROR: No students loaded yet!" << endl;
+            return;
+        }
+        
+        string filename;
+        cout << "\nEnter snapshot filename (default: students.snap): ";
+        getline(cin, filename);
+        if (filename.empty()) {
+            filename = "students.snap";
+        }
+        
+        // Make sure the persisted indexes are current
+        ensureSearchIndex(iiitManager, iiitSearchIndex);
+        ensureSearchIndex(iitManager, iitSearchIndex);
+        
+        saveSnapshot(filename, iiitManager, iiitSearchIndex, iitManager, iitSearchIndex);
+        
+        cout << "\n✓ Snapshot saved to: " << filename << endl;
+        cout << "  IIIT students: " << iiitManager.getTotalStudents() << endl;
+        cout << "  IIT students: " << iitManager.getTotalStudents() << endl;
+        
+    } catch (const exception& e) {
+        cerr << "\n❌ ERROR: Failed to save snapshot - " << e.what() << endl;
+    }
+}
+
+/**
+ * Replace all loaded data with the contents of a binary snapshot
+ */
+void loadSnapshotFile() {
+    try {
+        string filename;
+        cout << "\nEnter snapshot filename (default: students.snap): ";
+        getline(cin, filename);
+        if (filename.empty()) {
+            filename = "students.snap";
+        }
+        
+        auto startTime = chrono::steady_clock::now();
+        loadSnapshot(filename, iiitManager, iiitSearchIndex, iitManager, iitSearchIndex);
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - startTime).count();
+        
+        cout << "\n" << string(70, '=') << endl;
+        cout << "✓ Snapshot Loaded in " << elapsed / 1000.0 << " ms" << endl;
+        cout << "  IIIT students: " << iiitManager.getTotalStudents() << endl;
+        cout << "  IIT students: " << iitManager.getTotalStudents() << endl;
+        cout << string(70, '=') << endl;
+        
+    } catch (const exception& e) {
+        cerr << "\n❌ ERROR: Failed to load snapshot - " << e.what() << endl;
+    }
+}
+
+// ============================================================================
+// BATCH (NON-INTERACTIVE) MODE
+// ============================================================================
+
+/**
+ * One batch subcommand with its options, e.g. "sort --threads 8 --key year,name"
+ */
+struct BatchCommand {
+    string name;
+    map<string, string> options;
+    
+    bool has(const string& key) const {
+        return options.count(key) > 0;
+    }
+    
+    string get(const string& key, const string& fallback) const {
+        auto it = options.find(key);
+        return it == options.end() ? fallback : it->second;
+    }
+    
+    int getInt(const string& key, int fallback) const {
+        auto it = options.find(key);
+        if (it == options.end()) return fallback;
+        size_t used = 0;
+        int value = stoi(it->second, &used);
+        if (used != it->second.size()) {
+            throw invalid_argument("--" + key + " expects an integer, got '" + it->second + "'");
+        }
+        return value;
+    }
+    
+    // --threads N or --threads auto; auto (0) when absent
+    int getThreads() const {
+        string value = get("threads", "auto");
+        if (value == "auto") return SortingThreadsManager::AUTO_THREADS;
+        int threads = getInt("threads", SortingThreadsManager::AUTO_THREADS);
+        if (threads < 0) {
+            throw invalid_argument("--threads must be >= 0 or 'auto'");
+        }
+        return threads;
+    }
+};
+
+// Batch commands and the options each accepts
+const map<string, vector<string>> BATCH_COMMANDS = {
+    {"load", {"file", "presorted", "limit", "snapshot"}},
+    {"ingest", {"file", "parsers", "batch"}},
+    {"extsort", {"file", "out", "mem-mb", "io-kb", "threads", "system", "key", "tmp-dir"}},
+    {"sort", {"threads", "key", "system", "strategy", "pin"}},
+    {"export", {"out", "system"}},
+    {"index", {"system"}},
+    {"query", {"top", "roll", "min-grade", "course", "year-from", "year-to", "name-prefix", "roll-prefix",
+               "limit", "system", "semester", "sgpa-drop"}},
+    {"snapshot", {"out"}},
+    {"aggregate", {"by", "system", "threads", "limit"}},
+    {"serve", {"socket", "port", "workers", "ingest"}}
+};
+
+// Options accepted anywhere on the command line, for the whole run
+const vector<string> BATCH_GLOBAL_OPTIONS = {"metrics", "trace"};
+
+bool isBatchCommand(const string& word) {
+    return BATCH_COMMANDS.count(word) > 0;
+}
+
+/**
+ * Split argv into subcommands; options apply to the preceding subcommand
+ * An option not followed by a value (e.g. --presorted) is stored as "true"
+ * Global options (--metrics, --trace) are collected into `globals`
+ */
+vector<BatchCommand> parseBatchArguments(int argc, char* argv[], map<string, string>& globals) {
+    vector<BatchCommand> commands;
+    
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        
+        if (arg.rfind("--", 0) == 0 &&
+            find(BATCH_GLOBAL_OPTIONS.begin(), BATCH_GLOBAL_OPTIONS.end(), arg.substr(2)) != BATCH_GLOBAL_OPTIONS.end()) {
+            if (i + 1 >= argc) {
+                throw invalid_argument(arg + " needs a file name");
+            }
+            globals[arg.substr(2)] = argv[++i];
+        } else if (isBatchCommand(arg)) {
+            commands.push_back(BatchCommand{arg, {}});
+        } else if (arg.rfind("--", 0) == 0 && arg.size() > 2) {
+            if (commands.empty()) {
+                throw invalid_argument("Option " + arg + " must follow a command");
+            }
+            const auto& allowed = BATCH_COMMANDS.at(commands.back().name);
+            if (find(allowed.begin(), allowed.end(), arg.substr(2)) == allowed.end()) {
+                throw invalid_argument("Unknown option " + arg + " for '" + commands.back().name + "'");
+            }
+            string value = "true";
+            if (i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0 && !isBatchCommand(argv[i + 1])) {
+                value = argv[++i];
+            }
+            commands.back().options[arg.substr(2)] = value;
+        } else {
+            throw invalid_argument("Unknown command '" + arg + "' (try: erp_system help)");
+        }
+    }
+    
+    return commands;
+}
+
+void printBatchUsage() {
+    cout << "Usage: erp_system [command [--option value]...]..." << endl;
+    cout << "Without arguments the interactive menu is started." << endl;
+    cout << "\nCommands (run in the order given):" << endl;
+    cout << "  load      --file F [--presorted] [--limit N]   Load a CSV file" << endl;
+    cout << "  load      --snapshot F                         Load a binary snapshot" << endl;
+    cout << "  ingest    --file F [--parsers N] [--batch ROWS] Pipelined load + index + sorted view" << endl;
+    cout << "  extsort   --file F --out F [--mem-mb N] [--io-kb N] [--threads N|auto] [--system iiit|iit]" << endl;
+    cout << "            [--key year,name] [--tmp-dir D]        Sort a CSV larger than memory via disk runs" << endl;
+    cout << "  sort      [--threads N|auto] [--key year,name] [--system iiit|iit|both] [--strategy natural|merge|sample]" << endl;
+    cout << "            [--pin]                                Pin sort threads to CPUs, spread over NUMA nodes" << endl;
+    cout << "            keys: year, name, roll, branch, courses" << endl;
+    cout << "  export    [--out F] [--system iiit|iit|both]   Write sorted CSV" << endl;
+    cout << "  index     [--system iiit|iit|both]             Build search indexes" << endl;
+    cout << "  snapshot  --out F                              Save a binary snapshot" << endl;
+    cout << "  aggregate [--by branch,year,course] [--system iiit|iit|both] [--threads N|auto] [--limit N]" << endl;
+    cout << "            keys: branch, year, course, semester    Grade point count/sum/avg/min/max/histogram per group" << endl;
+    cout << "  query     --top N | --roll R | --min-grade G [--course C] [--system iiit|iit]" << endl;
+    cout << "  query     --year-from Y [--year-to Y] | --name-prefix P | --roll-prefix P [--limit N]" << endl;
+    cout << "  query     --semester S [--top N] | --sgpa-drop X [--limit N]   SGPA ranking / drops (IIIT)" << endl;
+    cout << "            Range and prefix lookups on the ordered indexes (roll prefix: iiit only)" << endl;
+    cout << "  serve     --socket PATH | --port N [--workers N]  Answer queries until SIGINT/SIGTERM" << endl;
+    cout << "            [--ingest F]                           Append F's rows while serving (GET sees them)" << endl;
+    cout << "            requests: GET roll | TOPK k | FILTER course grade | RANGE year1 year2 | COUNT | PING | QUIT" << endl;
+    cout << "            (prefix with 'iit ' for the IIT system)" << endl;
+    cout << "\nGlobal options:" << endl;
+    cout << "  --metrics F   Write spans/counters as JSON lines (or set ERP_METRICS=F)" << endl;
+    cout << "  --trace F     Write a Chrome trace_event file (or set ERP_TRACE=F)" << endl;
+    cout << "\nEvery step prints one JSON line with its timing on stdout." << endl;
+}
+
+string jsonEscape(const string& value) {
+    string out;
+    out.reserve(value.size() + 2);
+    out.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+    return out;
+}
+
+string jsonValue(const string& value) { return jsonEscape(value); }
+string jsonValue(unsigned int value) { return to_string(value); }
+string jsonValue(const PackedRoll& value) { return jsonEscape(value.str()); }
+
+double millisecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Emit one machine-readable timing line: {"step":...,"ms":...,<fields>}
+ */
+void emitTiming(const string& step, double ms, const string& fields = "") {
+    cout << "{\"step\":" << jsonEscape(step) << ",\"ms\":" << fixed << setprecision(3) << ms
+         << fields << "}" << endl;
+}
+
+bool parseRollArgument(const string& text, PackedRoll& roll) {
+    roll = PackedRoll(text);
+    return !roll.empty();
+}
+
+bool parseRollArgument(const string& text, unsigned int& roll) {
+    try {
+        size_t used = 0;
+        unsigned long value = stoul(text, &used);
+        if (used != text.size() || value > numeric_limits<unsigned int>::max()) return false;
+        roll = static_cast<unsigned int>(value);
+        return true;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+template<typename RollType, typename CourseType>
+string studentJSONFields(const Student<RollType, CourseType>& student) {
+    ostringstream out;
+    out << ",\"roll\":" << jsonValue(student.getRollNumber())
+        << ",\"name\":" << jsonEscape(student.getName())
+        << ",\"branch\":" << jsonEscape(student.getBranch())
+        << ",\"year\":" << student.getStartYear()
+        << ",\"courses\":" << student.getCourses().size()
+        << ",\"gpa\":" << fixed << setprecision(3) << student.getAverageGradePoints();
+    return out.str();
+}
+
+/**
+ * Which systems a command applies to: --system iiit|iit|both
+ */
+struct BatchSystems {
+    bool iiit;
+    bool iit;
+};
+
+BatchSystems parseBatchSystems(const BatchCommand& cmd, const string& fallback) {
+    string system = cmd.get("system", fallback);
+    if (system == "iiit") return {true, false};
+    if (system == "iit") return {false, true};
+    if (system == "both") return {true, true};
+    throw invalid_argument("--system must be iiit, iit or both");
+}
+
+void runBatchLoad(const BatchCommand& cmd) {
+    auto start = chrono::steady_clock::now();
+    
+    if (cmd.has("snapshot")) {
+        loadSnapshot(cmd.get("snapshot", ""), iiitManager, iiitSearchIndex, iitManager, iitSearchIndex);
+        emitTiming("load", millisecondsSince(start),
+                   ",\"source\":\"snapshot\",\"iiit\":" + to_string(iiitManager.getTotalStudents()) +
+                   ",\"iit\":" + to_string(iitManager.getTotalStudents()));
+        return;
+    }
+    
+    string filename = cmd.get("file", "students.csv");
+    LoadResult result = loadStudentsFromFile(filename, iiitManager, iitManager,
+                                             cmd.has("presorted"), cmd.getInt("limit", 0));
+    emitTiming("load", millisecondsSince(start),
+               ",\"source\":\"csv\",\"loaded\":" + to_string(result.successCount) +
+               ",\"errors\":" + to_string(result.errorCount) +
+               ",\"presorted\":" + (result.presortedApplied ? "true" : "false") +
+               ",\"iiit\":" + to_string(iiitManager.getTotalStudents()) +
+               ",\"iit\":" + to_string(iitManager.getTotalStudents()));
+}
+
+void runBatchIngest(const BatchCommand& cmd) {
+    IngestOptions options;
+    options.parserThreads = cmd.getInt("parsers", 0);
+    int batchRows = cmd.getInt("batch", 4096);
+    if (batchRows < 1) {
+        throw invalid_argument("--batch must be >= 1");
+    }
+    options.batchRows = batchRows;
+    
+    auto start = chrono::steady_clock::now();
+    IngestReport report = ingestStudentsFromFile(cmd.get("file", "students.csv"), options,
+                                                 iiitManager, iiitSearchIndex, iitManager, iitSearchIndex);
+    ostringstream fields;
+    fields << fixed << setprecision(3)
+           << ",\"loaded\":" << report.load.successCount
+           << ",\"errors\":" << report.load.errorCount
+           << ",\"iiit\":" << iiitManager.getTotalStudents()
+           << ",\"iit\":" << iitManager.getTotalStudents()
+           << ",\"parsers\":" << report.parserThreads
+           << ",\"batches\":" << report.batches
+           << ",\"runs\":" << report.iiitRuns + report.iitRuns
+           << ",\"read_ms\":" << report.readNs / 1e6
+           << ",\"parse_ms\":" << report.parseNs / 1e6
+           << ",\"assemble_ms\":" << report.assembleNs / 1e6
+           << ",\"merge_ms\":" << report.mergeNs / 1e6;
+    emitTiming("ingest", millisecondsSince(start), fields.str());
+}
+
+template<typename RollType, typename CourseType, typename Compare>
+ExternalSortReport externalSortFile(const ExternalSortOptions& options, Compare comp,
+                                    const string& inputFile, const string& outputFile) {
+    ExternalSorter<RollType, CourseType, Compare> sorter(options, comp);
+    return sorter.sortFile(inputFile, outputFile);
+}
+
+/**
+ * Sort one system's rows of a CSV file straight to a sorted CSV without
+ * loading it: nothing is added to the in-memory managers
+ */
+void runBatchExternalSort(const BatchCommand& cmd) {
+    if (!cmd.has("file") || !cmd.has("out")) {
+        throw invalid_argument("extsort needs --file and --out");
+    }
+    string system = cmd.get("system", "iiit");
+    if (system != "iiit" && system != "iit") {
+        throw invalid_argument("extsort --system must be iiit or iit");
+    }
+    int memoryMb = cmd.getInt("mem-mb", 256);
+    int ioKb = cmd.getInt("io-kb", 1024);
+    if (memoryMb < 1 || ioKb < 4) {
+        throw invalid_argument("--mem-mb must be >= 1 and --io-kb >= 4");
+    }
+    
+    ExternalSortOptions options;
+    options.memoryBytes = static_cast<size_t>(memoryMb) << 20;
+    options.ioBufferBytes = static_cast<size_t>(ioKb) << 10;
+    options.threads = cmd.getThreads();
+    options.tempDir = cmd.get("tmp-dir", "");
+    string inputFile = cmd.get("file", "");
+    string outputFile = cmd.get("out", "");
+    
+    auto start = chrono::steady_clock::now();
+    ExternalSortReport report;
+    if (cmd.has("key")) {
+        vector<StudentSortKey> keys = parseStudentSortKeys(cmd.get("key", ""));
+        report = system == "iiit"
+            ? externalSortFile<PackedRoll, IIITCourse>(options, StudentKeyCompare<IIITStudent>(keys), inputFile, outputFile)
+            : externalSortFile<unsigned int, IITCourse>(options, StudentKeyCompare<IITStudent>(keys), inputFile, outputFile);
+    } else {
+        report = system == "iiit"
+            ? externalSortFile<PackedRoll, IIITCourse>(options, less<IIITStudent>(), inputFile, outputFile)
+            : externalSortFile<unsigned int, IITCourse>(options, less<IITStudent>(), inputFile, outputFile);
+    }
+    
+    ostringstream fields;
+    fields << fixed << setprecision(3)
+           << ",\"system\":" << jsonEscape(system)
+           << ",\"records\":" << report.records
+           << ",\"errors\":" << report.errors
+           << ",\"runs\":" << report.runs
+           << ",\"merge_passes\":" << report.mergePasses
+           << ",\"spill_bytes\":" << report.spillBytes
+           << ",\"run_phase_ms\":" << report.runPhaseNs / 1e6
+           << ",\"merge_phase_ms\":" << report.mergePhaseNs / 1e6
+           << ",\"file\":" << jsonEscape(outputFile);
+    emitTiming("extsort", millisecondsSince(start), fields.str());
+}
+
+/**
+ * Phase breakdown of the last parallelSort as JSON fields
+ */
+string sortReportFields(const SortReport& report) {
+    ostringstream out;
+    out << fixed << setprecision(3)
+        << ",\"sort_phase_ms\":" << report.sortPhaseNs / 1e6
+        << ",\"merge_phase_ms\":" << report.mergePhaseNs / 1e6
+        << ",\"cpu_ms\":" << report.totalCpuNs / 1e6
+        << ",\"comparisons\":" << report.comparisons
+        << ",\"moves\":" << report.moves
+        << ",\"strategy\":\"" << sortStrategyName(report.strategy) << "\""
+        << ",\"runs\":" << report.runs
+        << ",\"merges_skipped\":" << report.mergesSkipped
+        << ",\"imbalance\":" << report.imbalance
+        << ",\"threads_used\":" << report.plan.threads
+        << ",\"auto\":" << (report.plan.automatic ? "true" : "false")
+        << ",\"sequential\":" << (report.plan.sequential ? "true" : "false")
+        << ",\"hardware_threads\":" << report.plan.hardwareThreads
+        << ",\"pinned\":" << (report.plan.pinned ? "true" : "false")
+        << ",\"numa_nodes\":" << report.plan.numaNodes;
+    return out.str();
+}
+
+void runBatchSort(const BatchCommand& cmd) {
+    int numThreads = cmd.getThreads();
+    string keySpec = cmd.get("key", "year,name");
+    vector<StudentSortKey> keys = parseStudentSortKeys(keySpec);
+    BatchSystems systems = parseBatchSystems(cmd, "both");
+    sortingManager.setStrategy(parseSortStrategy(cmd.get("strategy", "natural")));
+    sortingManager.setPinThreads(cmd.has("pin"));
+    
+    string fields = ",\"threads\":" + jsonEscape(threadCountLabel(numThreads)) + ",\"key\":" + jsonEscape(keySpec);
+    
+    if (systems.iiit) {
+        auto start = chrono::steady_clock::now();
+        sortManagerInPlace(iiitManager, iiitSearchIndex, numThreads, StudentKeyCompare<IIITStudent>(keys));
+        emitTiming("sort", millisecondsSince(start),
+                   ",\"system\":\"iiit\",\"records\":" + to_string(iiitManager.getTotalStudents()) + fields +
+                   sortReportFields(sortingManager.getLastReport()));
+    }
+    if (systems.iit) {
+        auto start = chrono::steady_clock::now();
+        sortManagerInPlace(iitManager, iitSearchIndex, numThreads, StudentKeyCompare<IITStudent>(keys));
+        emitTiming("sort", millisecondsSince(start),
+                   ",\"system\":\"iit\",\"records\":" + to_string(iitManager.getTotalStudents()) + fields +
+                   sortReportFields(sortingManager.getLastReport()));
+    }
+}
+
+void runBatchExport(const BatchCommand& cmd) {
+    BatchSystems systems = parseBatchSystems(cmd, "iiit");
+    if (systems.iiit && systems.iit && cmd.has("out")) {
+        throw invalid_argument("export --out needs a single --system");
+    }
+    
+    if (systems.iiit) {
+        string filename = cmd.get("out", "sorted_iiit_students.csv");
+        auto start = chrono::steady_clock::now();
+        size_t count = exportSortedCSV(iiitManager, iitManager, filename);
+        emitTiming("export", millisecondsSince(start),
+                   ",\"system\":\"iiit\",\"records\":" + to_string(count) + ",\"file\":" + jsonEscape(filename));
+    }
+    if (systems.iit) {
+        string filename = cmd.get("out", "sorted_iit_students.csv");
+        auto start = chrono::steady_clock::now();
+        size_t count = exportSortedCSV(iitManager, iiitManager, filename);
+        emitTiming("export", millisecondsSince(start),
+                   ",\"system\":\"iit\",\"records\":" + to_string(count) + ",\"file\":" + jsonEscape(filename));
+    }
+}
+
+void runBatchIndex(const BatchCommand& cmd) {
+    BatchSystems systems = parseBatchSystems(cmd, "both");
+    
+    if (systems.iiit) {
+        auto start = chrono::steady_clock::now();
+        ensureSearchIndex(iiitManager, iiitSearchIndex);
+        emitTiming("index", millisecondsSince(start),
+                   ",\"system\":\"iiit\",\"courses\":" + to_string(iiitSearchIndex.getCourseCount()));
+    }
+    if (systems.iit) {
+        auto start = chrono::steady_clock::now();
+        ensureSearchIndex(iitManager, iitSearchIndex);
+        emitTiming("index", millisecondsSince(start),
+                   ",\"system\":\"iit\",\"courses\":" + to_string(iitSearchIndex.getCourseCount()));
+    }
+}
+
+void runBatchSnapshot(const BatchCommand& cmd) {
+    string filename = cmd.get("out", "students.snap");
+    auto start = chrono::steady_clock::now();
+    ensureSearchIndex(iiitManager, iiitSearchIndex);
+    ensureSearchIndex(iitManager, iitSearchIndex);
+    saveSnapshot(filename, iiitManager, iiitSearchIndex, iitManager, iitSearchIndex);
+    emitTiming("snapshot", millisecondsSince(start), ",\"file\":" + jsonEscape(filename));
+}
+
+SortedOrderRange<const IIITStudent> rollPrefixRange(IIITStudentManager& manager, const string& prefix) {
+    return manager.getRollPrefixRange(prefix);
+}
+
+SortedOrderRange<const IITStudent> rollPrefixRange(StudentManager<unsigned int, IITCourse>&, const string&) {
+    throw invalid_argument("--roll-prefix needs --system iiit (IIT roll numbers are integers)");
+}
+
+/**
+ * Year range / name prefix / roll prefix queries on the ordered indexes:
+ * prints the first --limit matches (default 10) and the total count
+ */
+template<typename RollType, typename CourseType>
+void runBatchRangeQuery(const BatchCommand& cmd, const string& system, StudentManager<RollType, CourseType>& manager) {
+    string prefix = ",\"system\":" + jsonEscape(system);
+    int limit = cmd.getInt("limit", 10);
+    
+    if (!manager.hasOrderedIndexes()) {
+        auto buildStart = chrono::steady_clock::now();
+        manager.buildOrderedIndexes();
+        emitTiming("index", millisecondsSince(buildStart), prefix + ",\"ordered\":true");
+    }
+    
+    auto start = chrono::steady_clock::now();
+    string type;
+    SortedOrderRange<const Student<RollType, CourseType>> range(nullptr, nullptr, 0, 0);
+    if (cmd.has("name-prefix")) {
+        type = "name-prefix";
+        range = manager.getNamePrefixRange(cmd.get("name-prefix", ""));
+    } else if (cmd.has("roll-prefix")) {
+        type = "roll-prefix";
+        range = rollPrefixRange(manager, cmd.get("roll-prefix", ""));
+    } else {
+        type = "year-range";
+        int fromYear = cmd.getInt("year-from", numeric_limits<int>::min());
+        int toYear = cmd.getInt("year-to", numeric_limits<int>::max());
+        range = manager.getYearRange(fromYear, toYear);
+    }
+    double ms = millisecondsSince(start);
+    
+    int rank = 0;
+    for (const auto& student : range) {
+        if (rank >= limit) break;
+        cout << "{\"query\":" << jsonEscape(type) << prefix << ",\"rank\":" << ++rank
+             << studentJSONFields(student) << "}" << endl;
+    }
+    emitTiming("query", ms, prefix + ",\"type\":" + jsonEscape(type) + ",\"results\":" + to_string(range.size()));
+}
+
+/**
+ * Academic-warning queries on the semester index (IIIT): the best SGPAs of
+ * --semester S, or SGPA drops of more than --sgpa-drop X between
+ * consecutive semesters; prints the first --limit results (default 10)
+ */
+template<typename RollType, typename CourseType>
+void runBatchSemesterQuery(const BatchCommand& cmd, const string& system, StudentManager<RollType, CourseType>& manager) {
+    string prefix = ",\"system\":" + jsonEscape(system);
+    
+    if (!manager.hasSemesterIndex()) {
+        auto buildStart = chrono::steady_clock::now();
+        manager.buildSemesterIndex();
+        emitTiming("index", millisecondsSince(buildStart), prefix + ",\"semesters\":true");
+    }
+    
+    ostringstream out;
+    out << fixed << setprecision(3);
+    auto start = chrono::steady_clock::now();
+    if (cmd.has("sgpa-drop")) {
+        double minDrop = stod(cmd.get("sgpa-drop", "2"));
+        vector<SGPADrop> drops = manager.findSGPADrops(minDrop);
+        double ms = millisecondsSince(start);
+        size_t limit = static_cast<size_t>(max(cmd.getInt("limit", 10), 0));
+        for (size_t rank = 0; rank < drops.size() && rank < limit; rank++) {
+            const SGPADrop& drop = drops[rank];
+            out << "{\"query\":\"sgpa-drop\"" << prefix << ",\"rank\":" << rank + 1
+                << ",\"from_semester\":" << drop.fromSemester << ",\"to_semester\":" << drop.toSemester
+                << ",\"from_sgpa\":" << drop.fromSGPA << ",\"to_sgpa\":" << drop.toSGPA
+                << studentJSONFields(manager.getStudent(drop.student)) << "}\n";
+        }
+        cout << out.str() << flush;
+        emitTiming("query", ms, prefix + ",\"type\":\"sgpa-drop\",\"results\":" + to_string(drops.size()));
+    } else {
+        int semester = cmd.getInt("semester", 1);
+        int k = cmd.getInt("top", 10);
+        vector<SemesterRank> top = manager.findTopSGPA(semester, k < 0 ? 0 : k);
+        double ms = millisecondsSince(start);
+        for (size_t rank = 0; rank < top.size(); rank++) {
+            out << "{\"query\":\"top-sgpa\"" << prefix << ",\"rank\":" << rank + 1
+                << ",\"semester\":" << semester << ",\"sgpa\":" << top[rank].sgpa << ",\"cgpa\":" << top[rank].cgpa
+                << studentJSONFields(manager.getStudent(top[rank].student)) << "}\n";
+        }
+        cout << out.str() << flush;
+        emitTiming("query", ms, prefix + ",\"type\":\"top-sgpa\",\"semester\":" + to_string(semester) +
+                   ",\"results\":" + to_string(top.size()));
+    }
+}
+
+template<typename RollType, typename CourseType>
+void runBatchQueryOn(const BatchCommand& cmd, const string& system,
+                     StudentManager<RollType, CourseType>& manager, SearchIndex<CourseType>& index) {
+    auto start = chrono::steady_clock::now();
+    string prefix = ",\"system\":" + jsonEscape(system);
+    
+    if (cmd.has("sgpa-drop") || cmd.has("semester")) {
+        runBatchSemesterQuery(cmd, system, manager);
+    } else if (cmd.has("top")) {
+        int k = cmd.getInt("top", 10);
+        vector<int> top = manager.findTopStudents(k < 0 ? 0 : k);
+        double ms = millisecondsSince(start);
+        for (size_t rank = 0; rank < top.size(); rank++) {
+            cout << "{\"query\":\"top\"" << prefix << ",\"rank\":" << rank + 1
+                 << studentJSONFields(manager.getStudent(top[rank])) << "}" << endl;
+        }
+        emitTiming("query", ms, prefix + ",\"type\":\"top\",\"results\":" + to_string(top.size()));
+    } else if (cmd.has("roll")) {
+        RollType roll;
+        if (!parseRollArgument(cmd.get("roll", ""), roll)) {
+            throw invalid_argument("Invalid roll number for " + system + ": " + cmd.get("roll", ""));
+        }
+        int found = manager.findByRoll(roll);
+        double ms = millisecondsSince(start);
+        if (found >= 0) {
+            cout << "{\"query\":\"roll\"" << prefix << studentJSONFields(manager.getStudent(found)) << "}" << endl;
+        }
+        emitTiming("query", ms, prefix + ",\"type\":\"roll\",\"results\":" + to_string(found >= 0 ? 1 : 0));
+    } else if (cmd.has("min-grade")) {
+        int minGrade = cmd.getInt("min-grade", 9);
+        ensureSearchIndex(manager, index);
+        vector<int> results = cmd.has("course")
+            ? index.findStudentsByGradeInCourse(cmd.get("course", ""), minGrade)
+            : index.findAllStudentsByGrade(minGrade);
+        emitTiming("query", millisecondsSince(start),
+                   prefix + ",\"type\":\"min-grade\",\"min_grade\":" + to_string(minGrade) +
+                   ",\"results\":" + to_string(results.size()));
+    } else if (cmd.has("year-from") || cmd.has("year-to") || cmd.has("name-prefix") || cmd.has("roll-prefix")) {
+        runBatchRangeQuery(cmd, system, manager);
+    } else {
+        throw invalid_argument("query needs --top N, --roll R, --min-grade G, --year-from/--year-to Y, "
+                               "--name-prefix P, --roll-prefix P, --semester S or --sgpa-drop X");
+    }
+}
+
+void runBatchQuery(const BatchCommand& cmd) {
+    BatchSystems systems = parseBatchSystems(cmd, "iiit");
+    if (systems.iiit) runBatchQueryOn(cmd, "iiit", iiitManager, iiitSearchIndex);
+    if (systems.iit) runBatchQueryOn(cmd, "iit", iitManager, iitSearchIndex);
+}
+
+/**
+ * Grade statistics per group: one JSON line per group (the first --limit,
+ * default all), then the timing line
+ */
+template<typename RollType, typename CourseType>
+void runBatchAggregateOn(const BatchCommand& cmd, const string& system,
+                         const StudentManager<RollType, CourseType>& manager) {
+    string keySpec = cmd.get("by", "branch,year,course");
+    vector<GroupKey> keys = parseGroupKeys(keySpec);
+    int limit = cmd.getInt("limit", 0);
+    string prefix = ",\"system\":" + jsonEscape(system);
+    
+    auto start = chrono::steady_clock::now();
+    AggregateReport report = manager.aggregate(keys, cmd.getThreads());
+    double ms = millisecondsSince(start);
+    
+    size_t shown = limit > 0 ? min(report.groups.size(), static_cast<size_t>(limit)) : report.groups.size();
+    ostringstream out;
+    out << fixed << setprecision(3);
+    for (size_t g = 0; g < shown; g++) {
+        const AggregateGroup& group = report.groups[g];
+        out << "{\"aggregate\":" << jsonEscape(keySpec) << prefix;
+        for (size_t i = 0; i < keys.size(); i++) {
+            out << ",\"" << groupKeyName(keys[i]) << "\":"
+                << (report.numericKey[i] ? group.key[i] : jsonEscape(group.key[i]));
+        }
+        const GradeAggregate& stats = group.stats;
+        out << ",\"count\":" << stats.count << ",\"sum\":" << stats.sum << ",\"avg\":" << stats.average()
+            << ",\"min\":" << stats.min << ",\"max\":" << stats.max << ",\"histogram\":{";
+        bool first = true;
+        for (int points = GradeAggregate::MAX_POINTS; points >= 0; points--) {
+            if (stats.histogram[points] == 0) continue;
+            out << (first ? "" : ",") << "\"" << points << "\":" << stats.histogram[points];
+            first = false;
+        }
+        out << "}}\n";
+    }
+    cout << out.str() << flush;
+    
+    ostringstream fields;
+    fields << fixed << setprecision(3) << prefix
+           << ",\"by\":" << jsonEscape(keySpec)
+           << ",\"students\":" << report.students
+           << ",\"enrollments\":" << report.enrollments
+           << ",\"groups\":" << report.groups.size()
+           << ",\"threads\":" << report.threads
+           << ",\"partial_ms\":" << report.partialNs / 1e6
+           << ",\"merge_ms\":" << report.mergeNs / 1e6;
+    emitTiming("aggregate", ms, fields.str());
+}
+
+void runBatchAggregate(const BatchCommand& cmd) {
+    BatchSystems systems = parseBatchSystems(cmd, "iiit");
+    if (systems.iiit) runBatchAggregateOn(cmd, "iiit", iiitManager);
+    if (systems.iit) runBatchAggregateOn(cmd, "iit", iitManager);
+}
+
+// ============================================================================
+// QUERY SERVER MODE
+// ============================================================================
+
+// Longest roll list returned by FILTER / RANGE; "count" is always exact
+const size_t SERVER_RESULT_LIMIT = 100;
+
+template<typename RollType, typename CourseType>
+string studentJSON(const Student<RollType, CourseType>& student) {
+    return "{" + studentJSONFields(student).substr(1) + "}";
+}
+
+template<typename RollType, typename CourseType>
+string rollListJSON(const StudentManager<RollType, CourseType>& manager, const vector<int>& indices) {
+    string out = "{\"count\":" + to_string(indices.size()) + ",\"rolls\":[";
+    size_t shown = min(indices.size(), SERVER_RESULT_LIMIT);
+    for (size_t i = 0; i < shown; i++) {
+        if (i > 0) out += ",";
+        out += jsonValue(manager.getStudent(indices[i]).getRollNumber());
+    }
+    out += string("],\"truncated\":") + (shown < indices.size() ? "true" : "false") + "}";
+    return out;
+}
+
+int parseQueryInt(const string& text) {
+    size_t used = 0;
+    int value = stoi(text, &used);
+    if (used != text.size()) {
+        throw invalid_argument("expected an integer, got '" + text + "'");
+    }
+    return value;
+}
+
+/**
+ * Answer one request against a manager and its index (both read-only here,
+ * so any number of server workers may call this concurrently)
+ */
+template<typename RollType, typename CourseType>
+string answerQuery(const vector<string>& words, const StudentManager<RollType, CourseType>& manager,
+                   const SearchIndex<CourseType>& index,
+                   const ConcurrentStudentManager<RollType, CourseType>& live) {
+    const string& cmd = words[0];
+    
+    if (cmd == "GET" && words.size() == 2) {
+        RollType roll;
+        if (!parseRollArgument(words[1], roll)) {
+            return "ERR invalid roll number '" + words[1] + "'";
+        }
+        int found = manager.findByRoll(roll);
+        if (found >= 0) return "OK " + studentJSON(manager.getStudent(found));
+        auto view = live.snapshot();
+        const Student<RollType, CourseType>* ingested = view->findByRoll(roll);
+        return ingested ? "OK " + studentJSON(*ingested) : "NOTFOUND";
+    }
+    if (cmd == "COUNT" && words.size() == 1) {
+        return "OK {\"loaded\":" + to_string(manager.getTotalStudents()) +
+               ",\"ingested\":" + to_string(live.getPublishedStudents()) + "}";
+    }
+    if (cmd == "TOPK" && words.size() == 2) {
+        int k = parseQueryInt(words[1]);
+        vector<int> top = manager.findTopStudents(k < 0 ? 0 : k);
+        string out = "OK [";
+        for (size_t i = 0; i < top.size(); i++) {
+            if (i > 0) out += ",";
+            out += studentJSON(manager.getStudent(top[i]));
+        }
+        return out + "]";
+    }
+    if (cmd == "FILTER" && words.size() == 3) {
+        int minGrade = parseQueryInt(words[2]);
+        return "OK " + rollListJSON(manager, index.findStudentsByGradeInCourse(words[1], minGrade));
+    }
+    if (cmd == "RANGE" && words.size() == 3) {
+        int fromYear = parseQueryInt(words[1]);
+        int toYear = parseQueryInt(words[2]);
+        return "OK " + rollListJSON(manager, manager.findByYearRange(fromYear, toYear));
+    }
+    return "ERR usage: GET roll | TOPK k | FILTER course grade | RANGE year1 year2 | COUNT";
+}
+
+/**
+ * Server request handler: "[iiit|iit] COMMAND args..." -> one response line
+ */
+string handleQueryRequest(const string& line) {
+    ScopedTimer span("server.request", "search");
+    vector<string> words;
+    istringstream in(line);
+    string word;
+    while (in >> word) words.push_back(word);
+    if (words.empty()) return "ERR empty request";
+    
+    string system = "iiit";
+    if (words[0] == "iiit" || words[0] == "iit") {
+        system = words[0];
+        words.erase(words.begin());
+        if (words.empty()) return "ERR missing command";
+    }
+    transform(words[0].begin(), words[0].end(), words[0].begin(), ::toupper);
+    
+    if (words[0] == "PING") return "PONG";
+    return system == "iiit" ? answerQuery(words, as_const(iiitManager), as_const(iiitSearchIndex), iiitLiveStore)
+                            : answerQuery(words, as_const(iitManager), as_const(iitSearchIndex), iitLiveStore);
+}
+
+QueryServer* activeServer = nullptr;
+
+void stopActiveServer(int) {
+    if (activeServer) activeServer->stop();
+}
+
+/**
+ * Append CSV rows (header already read) to the live stores until the stream
+ * ends or `stop` is set; runs beside the server, and each full batch becomes
+ * visible to GET as soon as it is published
+ */
+LoadResult appendToLiveStores(istream& file, const atomic<bool>& stop) {
+    ScopedTimer span("serve.ingest", "load");
+    LoadResult result;
+    string line;
+    int lineNumber = 1;
+    while (!stop.load(memory_order_relaxed) && getline(file, line)) {
+        lineNumber++;
+        RowOutcome outcome = parseStudentRow(line, lineNumber,
+            [](IIITStudent&& student) { iiitLiveStore.addStudent(std::move(student)); },
+            [](IITStudent&& student) { iitLiveStore.addStudent(std::move(student)); });
+        if (outcome.accepted) result.successCount++;
+        result.errorCount += outcome.errors;
+    }
+    iiitLiveStore.publish();
+    iitLiveStore.publish();
+    span.arg("rows", result.successCount);
+    return result;
+}
+
+void runBatchServe(const BatchCommand& cmd) {
+    if (cmd.has("socket") == cmd.has("port")) {
+        throw invalid_argument("serve needs exactly one of --socket PATH or --port N");
+    }
+    ifstream ingestFile;
+    if (cmd.has("ingest")) {
+        string ingestPath = cmd.get("ingest", "");
+        ingestFile.open(ingestPath);
+        if (!ingestFile.is_open()) {
+            throw runtime_error("Could not open file: " + ingestPath);
+        }
+        string header;
+        if (!getline(ingestFile, header)) {
+            throw runtime_error("File is empty or cannot be read: " + ingestPath);
+        }
+    }
+    auto start = chrono::steady_clock::now();
+    
+    // Everything the handlers read is built up front; serving is read-only
+    ensureSearchIndex(iiitManager, iiitSearchIndex);
+    ensureSearchIndex(iitManager, iitSearchIndex);
+    iiitManager.buildRollIndex();
+    iitManager.buildRollIndex();
+    iiitManager.buildOrderedIndexes();
+    iitManager.buildOrderedIndexes();
+    
+    int workers = cmd.getInt("workers", 4);
+    QueryServer server(handleQueryRequest, workers);
+    string address;
+    if (cmd.has("socket")) {
+        address = cmd.get("socket", "");
+        server.listenUnix(address);
+    } else {
+        server.listenTcp(cmd.getInt("port", 0));
+        address = "127.0.0.1:" + to_string(server.getPort());
+    }
+    emitTiming("listen", millisecondsSince(start),
+               ",\"address\":" + jsonEscape(address) + ",\"workers\":" + to_string(workers));
+    
+    activeServer = &server;
+    struct sigaction action{};
+    action.sa_handler = stopActiveServer;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    
+    // The loader appends while the workers answer from published snapshots
+    atomic<bool> stopIngest(false);
+    LoadResult ingested;
+    thread loader;
+    if (cmd.has("ingest")) {
+        loader = thread([&] {
+            Metrics::instance().setThreadName("serve-ingest");
+            ingested = appendToLiveStores(ingestFile, stopIngest);
+        });
+    }
+    
+    auto serveStart = chrono::steady_clock::now();
+    server.run();
+    stopIngest = true;
+    if (loader.joinable()) loader.join();
+    
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    activeServer = nullptr;
+    string ingestFields;
+    if (cmd.has("ingest")) {
+        ingestFields = ",\"ingested\":" + to_string(ingested.successCount) +
+                       ",\"ingest_errors\":" + to_string(ingested.errorCount);
+    }
+    emitTiming("serve", millisecondsSince(serveStart),
+               ",\"requests\":" + to_string(server.getRequestsServed()) +
+               ",\"connections\":" + to_string(server.getConnectionsAccepted()) + ingestFields);
+}
+
+/**
+ * Enable metrics/trace output; empty paths fall back to ERP_METRICS / ERP_TRACE
+ * Throws runtime_error if an output file cannot be created
+ */
+void startMetrics(string metricsPath, string tracePath) {
+    if (metricsPath.empty() && getenv("ERP_METRICS")) metricsPath = getenv("ERP_METRICS");
+    if (tracePath.empty() && getenv("ERP_TRACE")) tracePath = getenv("ERP_TRACE");
+    if (metricsPath.empty() && tracePath.empty()) return;
+    
+    Metrics::instance().open(metricsPath, tracePath);
+    Metrics::instance().setThreadName("main");
+}
+
+/**
+ * Run the subcommands given on the command line, in order, without prompts
+ * @return Process exit code
+ */
+int runBatch(int argc, char* argv[]) {
+    string first = argv[1];
+    if (first == "help" || first == "--help" || first == "-h") {
+        printBatchUsage();
+        return 0;
+    }
+    
+    try {
+        map<string, string> globals;
+        vector<BatchCommand> commands = parseBatchArguments(argc, argv, globals);
+        startMetrics(globals.count("metrics") ? globals["metrics"] : "",
+                     globals.count("trace") ? globals["trace"] : "");
+        sortingManager.setVerbose(false);
+        
+        auto start = chrono::steady_clock::now();
+        for (const auto& cmd : commands) {
+            ScopedTimer span(cmd.name.c_str(), "batch");
+            if (cmd.name == "load") runBatchLoad(cmd);
+            else if (cmd.name == "ingest") runBatchIngest(cmd);
+            else if (cmd.name == "extsort") runBatchExternalSort(cmd);
+            else if (cmd.name == "sort") runBatchSort(cmd);
+            else if (cmd.name == "export") runBatchExport(cmd);
+            else if (cmd.name == "index") runBatchIndex(cmd);
+            else if (cmd.name == "snapshot") runBatchSnapshot(cmd);
+            else if (cmd.name == "query") runBatchQuery(cmd);
+            else if (cmd.name == "aggregate") runBatchAggregate(cmd);
+            else if (cmd.name == "serve") runBatchServe(cmd);
+        }
+        emitTiming("total", millisecondsSince(start), ",\"commands\":" + to_string(commands.size()));
+        
+    } catch (const exception& e) {
+        cerr << "❌ ERROR: " << e.what() << endl;
+        return 1;
+    }
+    
+    return 0;
+}
+
 // ============================================================================
 // MAIN MENU
 // ============================================================================
@@ -932,6 +1702,8 @@ void displayMainMenu() {
     
     cout << "\n🔍 ADVANCED FEATURES" << endl;
     cout << " 10. Search Index Demo (High Performers)" << endl;
+    cout << " 11. Save Binary Snapshot" << endl;
+    cout << " 12. Load Binary Snapshot" << endl;
     
     cout << "\n🚪 EXIT" << endl;
     cout << "  0. Exit Program" << endl;
@@ -941,9 +1713,16 @@ void displayMainMenu() {
 
 /**
  * Main program entry point
+ * With command-line arguments, runs in batch mode instead of the menu
  */
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runBatch(argc, argv);
+    }
+    
     try {
+        startMetrics("", "");
+        
         cout << "\n╔════════════════════════════════════════════════════════════════════╗" << endl;
         cout << "║          OOPD Assignment 4: Templates & Threads                    ║" << endl;
         cout << "║          Student Management System with Parallel Sorting           ║" << endl;
@@ -955,8 +1734,8 @@ int main() {
         while (running) {
             try {
                 displayMainMenu();
-                cout << "\nEnter your choice (0-10): ";
-                choice = getValidatedInteger(0, 10);
+                cout << "\nEnter your choice (0-12): ";
+                choice = getValidatedInteger(0, 12);
                 
                 switch (choice) {
                     case 0:
@@ -1005,8 +1784,16 @@ int main() {
                         demonstrateSearchIndex();
                         break;
                         
+                    case 11:
+                        saveSnapshotFile();
+                        break;
+                        
+                    case 12:
+                        loadSnapshotFile();
+                        break;
+                        
                     default:
-                        cout << "\n❌ Invalid choice! Please select 0-10." << endl;
+                        cout << "\n❌ Invalid choice! Please select 0-12." << endl;
                 }
                 
                 if (running && choice != 0) {
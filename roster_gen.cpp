@@ -0,0 +1,132 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <stdexcept>
+#include "RosterGenerator.h"
+
+using namespace std;
+
+/**
+ * Streaming synthetic roster generator
+ * Rows are formatted into a fixed-size buffer and written with fwrite,
+ * so memory use stays constant regardless of the row count
+ */
+
+void printUsage() {
+    cout << "Usage: roster_gen --rows N [options]" << endl;
+    cout << "  --rows N                 Number of data rows (required)" << endl;
+    cout << "  --out FILE               Output file (default: stdout)" << endl;
+    cout << "  --seed N                 Generator seed (default 42)" << endl;
+    cout << "  --string-roll-ratio R    Fraction of MT-style string rolls (default 0.45)" << endl;
+    cout << "  --iiit-courses MIN-MAX   IIIT courses per student (default 1-5)" << endl;
+    cout << "  --iit-courses MIN-MAX    IIT courses per student (default 0-3)" << endl;
+    cout << "  --catalog N              Distinct course codes per system, max 32 (default 5)" << endl;
+    cout << "  --skew S                 Zipf exponent for course/branch/year popularity (default 0)" << endl;
+    cout << "  --dup-ratio R            Fraction of rows reusing an earlier roll (default 0)" << endl;
+    cout << "  --malformed-ratio R      Fraction of deliberately broken rows (default 0)" << endl;
+}
+
+void parseRange(const string& text, int& lo, int& hi) {
+    size_t dash = text.find('-');
+    if (dash == string::npos) {
+        lo = hi = stoi(text);
+    } else {
+        lo = stoi(text.substr(0, dash));
+        hi = stoi(text.substr(dash + 1));
+    }
+    if (lo < 0 || hi < lo) {
+        throw invalid_argument("Invalid range '" + text + "'");
+    }
+}
+
+double parseRatio(const string& text) {
+    double value = stod(text);
+    if (value < 0.0 || value > 1.0) {
+        throw invalid_argument("Ratio must be between 0 and 1: " + text);
+    }
+    return value;
+}
+
+int main(int argc, char* argv[]) {
+    RosterConfig config;
+    uint64_t rows = 0;
+    bool haveRows = false;
+    string outPath;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            auto value = [&]() -> string {
+                if (i + 1 >= argc) throw invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+
+            if (arg == "--rows") { rows = stoull(value()); haveRows = true; }
+            else if (arg == "--out") outPath = value();
+            else if (arg == "--seed") config.seed = stoull(value());
+            else if (arg == "--string-roll-ratio") config.stringRollRatio = parseRatio(value());
+            else if (arg == "--iiit-courses") parseRange(value(), config.minIIITCourses, config.maxIIITCourses);
+            else if (arg == "--iit-courses") parseRange(value(), config.minIITCourses, config.maxIITCourses);
+            else if (arg == "--catalog") config.iiitCatalogSize = config.iitCatalogSize = stoi(value());
+            else if (arg == "--skew") config.skew = stod(value());
+            else if (arg == "--dup-ratio") config.duplicateRatio = parseRatio(value());
+            else if (arg == "--malformed-ratio") config.malformedRatio = parseRatio(value());
+            else if (arg == "--help" || arg == "-h") {
+                printUsage();
+                return 0;
+            } else {
+                throw invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (!haveRows) {
+            printUsage();
+            return 1;
+        }
+        if (config.skew < 0) {
+            throw invalid_argument("--skew must be >= 0");
+        }
+
+        FILE* out = outPath.empty() ? stdout : fopen(outPath.c_str(), "wb");
+        if (!out) {
+            throw runtime_error("Could not create file: " + outPath);
+        }
+
+        const size_t flushThreshold = 1 << 20;
+        string buffer;
+        buffer.reserve(flushThreshold + 4096);
+        buffer.append(RosterGenerator::header());
+        buffer.push_back('\n');
+
+        RosterGenerator generator(config);
+        bool ok = true;
+        for (uint64_t row = 0; row < rows && ok; row++) {
+            generator.appendRow(buffer);
+            if (buffer.size() >= flushThreshold) {
+                ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+                buffer.clear();
+            }
+        }
+        if (ok && !buffer.empty()) {
+            ok = fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+        }
+        if (out != stdout) {
+            ok = (fclose(out) == 0) && ok;
+        } else {
+            ok = (fflush(out) == 0) && ok;
+        }
+        if (!ok) {
+            throw runtime_error("Write failed" + (outPath.empty() ? string() : ": " + outPath));
+        }
+
+        if (!outPath.empty()) {
+            cerr << "✓ Wrote " << rows << " rows to " << outPath << endl;
+        }
+
+    } catch (const exception& e) {
+        cerr << "❌ ERROR: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}